@@ -0,0 +1,150 @@
+#ifndef AGGREGATION_H
+#define AGGREGATION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+// Frame aggregation (802.11n/ac/ax A-MPDU and A-MSDU).
+// Without aggregation a scheduled user sends one packet per transmission,
+// as an ideal bit pipe: airtime = bits / rate and nothing else. With it the
+// user sends every queued packet, up to the block-ack window, the maximum
+// PPDU duration and what is left of its TXOP or frame, as one burst:
+//   A-MPDU  preamble, then per packet an MPDU (delimiter, MAC header, FCS,
+//           padded to 4 bytes), then SIFS and a block ack covering every MPDU
+//   A-MSDU  preamble, one MPDU holding every packet as an MSDU subframe
+//           (subframe header, padded to 4 bytes) up to the A-MSDU size limit,
+//           then SIFS and a normal ack
+// The burst is one scheduling decision and one TxStart / TxEnd pair, and
+// every packet in it completes when the acknowledgement ends. There is no
+// error model: each MPDU is acknowledged.
+
+enum class AggregationMode { Off, Ampdu, Amsdu };
+
+// PHY / MAC framing of one standard
+struct AggregationTiming {
+    double preamble;        // PHY preamble and headers (seconds)
+    double sifs;
+    double blockAck;        // Compressed block ack at a legacy basic rate, preamble included
+    double ack;             // Normal ack after an A-MSDU
+    int blockAckWindow;     // MPDUs one block ack can cover
+    int maxAmsduBytes;
+};
+
+// VHT (802.11ac): 40 us preamble with one VHT-LTF, 64-MPDU window
+const AggregationTiming VHT_AGGREGATION = {40e-6, 16e-6, 32e-6, 28e-6, 64, 7935};
+// HE (802.11ax): 48 us HE trigger-based preamble, 256-MPDU window
+const AggregationTiming HE_AGGREGATION = {48e-6, 16e-6, 32e-6, 28e-6, 256, 11454};
+
+const double MAX_PPDU_SECONDS = 5.484e-3;   // aPPDUMaxTime
+const int MPDU_OVERHEAD_BYTES = 38;         // 4 delimiter + 30 QoS data MAC header + 4 FCS
+const int MPDU_HEADER_BYTES = 34;           // MAC header + FCS around an A-MSDU
+const int MSDU_SUBFRAME_HEADER_BYTES = 14;
+
+inline int padTo4(int bytes) { return (bytes + 3) & ~3; }
+
+// Command-line options: --aggregation=off|ampdu|amsdu [--max-frames=N] [--max-ppdu=S]
+struct AggregationOptions {
+    AggregationMode mode = AggregationMode::Off;
+    int maxFrames = 0;                      // Packets per burst, 0 = the standard's block-ack window
+    double maxPpduSeconds = MAX_PPDU_SECONDS;
+
+    bool enabled() const { return mode != AggregationMode::Off; }
+};
+
+inline AggregationOptions parseAggregationArguments(int argc, char* argv[]) {
+    AggregationOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 14, "--aggregation=") == 0) {
+            std::string mode = arg.substr(14);
+            if (mode == "off") opts.mode = AggregationMode::Off;
+            else if (mode == "ampdu") opts.mode = AggregationMode::Ampdu;
+            else if (mode == "amsdu") opts.mode = AggregationMode::Amsdu;
+            else throw std::invalid_argument("Unknown aggregation " + mode + ": expected off, ampdu or amsdu.");
+        } else if (arg.compare(0, 13, "--max-frames=") == 0) {
+            opts.maxFrames = std::atoi(arg.c_str() + 13);
+        } else if (arg.compare(0, 11, "--max-ppdu=") == 0) {
+            opts.maxPpduSeconds = std::atof(arg.c_str() + 11);
+        }
+    }
+    if (opts.maxFrames < 0 || !(opts.maxPpduSeconds > 0)) throw std::invalid_argument("--max-frames and --max-ppdu must be positive.");
+    return opts;
+}
+
+// Aggregator Class: burst sizes and airtimes for one standard's framing
+class Aggregator {
+private:
+    AggregationOptions options;
+    AggregationTiming timing;
+    int frameLimit;
+
+public:
+    Aggregator(const AggregationOptions& opts = AggregationOptions(), const AggregationTiming& t = VHT_AGGREGATION)
+        : options(opts), timing(t), frameLimit(opts.maxFrames > 0 ? std::min(opts.maxFrames, t.blockAckWindow) : t.blockAckWindow) {}
+
+    bool enabled() const { return options.enabled(); }
+    AggregationMode mode() const { return options.mode; }
+
+    // Packets of `payloadBytes` that one burst may carry at most (1 when aggregation is off)
+    int maxFrames(int payloadBytes) const {
+        if (options.mode == AggregationMode::Off) return 1;
+        if (options.mode == AggregationMode::Amsdu) {
+            int fit = (timing.maxAmsduBytes + padTo4(MSDU_SUBFRAME_HEADER_BYTES + payloadBytes) - (MSDU_SUBFRAME_HEADER_BYTES + payloadBytes)) /
+                      padTo4(MSDU_SUBFRAME_HEADER_BYTES + payloadBytes);  // The last subframe is not padded
+            return std::max(1, std::min(frameLimit, fit));
+        }
+        return frameLimit;
+    }
+
+    // Airtime per packet in a burst, and the PPDU time that does not depend on the packet count
+    double frameAirtime(int payloadBytes, double rate) const {
+        switch (options.mode) {
+        case AggregationMode::Ampdu: return padTo4(MPDU_OVERHEAD_BYTES + payloadBytes) * 8.0 / rate;
+        case AggregationMode::Amsdu: return padTo4(MSDU_SUBFRAME_HEADER_BYTES + payloadBytes) * 8.0 / rate;
+        default: return payloadBytes * 8.0 / rate;
+        }
+    }
+
+    double fixedAirtime(double rate) const {
+        switch (options.mode) {
+        case AggregationMode::Ampdu: return timing.preamble;
+        case AggregationMode::Amsdu: return timing.preamble + MPDU_HEADER_BYTES * 8.0 / rate;
+        default: return 0;
+        }
+    }
+
+    // SIFS and the acknowledgement after the PPDU
+    double acknowledgement() const {
+        switch (options.mode) {
+        case AggregationMode::Ampdu: return timing.sifs + timing.blockAck;
+        case AggregationMode::Amsdu: return timing.sifs + timing.ack;
+        default: return 0;
+        }
+    }
+
+    double ppduDuration(int frames, int payloadBytes, double rate) const {
+        return fixedAirtime(rate) + frames * frameAirtime(payloadBytes, rate);
+    }
+
+    // Medium time of the whole exchange: PPDU, SIFS and the acknowledgement
+    double exchangeDuration(int frames, int payloadBytes, double rate) const {
+        return ppduDuration(frames, payloadBytes, rate) + acknowledgement();
+    }
+
+    // Largest burst of at most `queued` packets whose PPDU stays under the maximum and whose exchange ends
+    // within `budget` seconds (infinity = no limit); at least one packet if `forceOne`
+    int burstSize(int queued, int payloadBytes, double rate, double budget, bool forceOne) const {
+        double perFrame = frameAirtime(payloadBytes, rate), fixed = fixedAirtime(rate);
+        double limit = std::min({static_cast<double>(std::min(queued, maxFrames(payloadBytes))),
+                                 std::floor((options.maxPpduSeconds - fixed) / perFrame),
+                                 std::floor((budget - fixed - acknowledgement()) / perFrame)});
+        int frames = std::max(0, static_cast<int>(limit));
+        if (frames > 0 && exchangeDuration(frames, payloadBytes, rate) > budget) frames--;  // Rounding at the boundary
+        return frames == 0 && forceOne && queued > 0 ? 1 : frames;
+    }
+};
+
+#endif
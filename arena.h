@@ -0,0 +1,58 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Per-simulation monotonic arena. Users, their queues and channel state are
+// bump-allocated from one buffer; teardown runs the registered destructors
+// (which free nothing) and hands the whole buffer back in a single release.
+
+// Simulation Arena Class
+class SimulationArena {
+private:
+    struct Owned {
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    std::pmr::monotonic_buffer_resource buffer;
+    std::pmr::vector<Owned> owned;  // Objects with non-trivial destructors, in construction order
+
+    template <typename T>
+    static void destroyObject(void* p) { static_cast<T*>(p)->~T(); }
+
+public:
+    explicit SimulationArena(size_t initialBytes = 4096,
+                             std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : buffer(initialBytes, upstream), owned(&buffer) {}
+
+    ~SimulationArena() { release(); }
+
+    SimulationArena(const SimulationArena&) = delete;
+    SimulationArena& operator=(const SimulationArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &buffer; }
+
+    // Construct a T inside the arena; it lives until release()
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        void* mem = buffer.allocate(sizeof(T), alignof(T));
+        T* obj = ::new (mem) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) owned.push_back(Owned{obj, &destroyObject<T>});
+        return obj;
+    }
+
+    // Destroy every arena object (newest first) and return all memory upstream at once
+    void release() {
+        for (size_t i = owned.size(); i > 0; --i) owned[i - 1].destroy(owned[i - 1].object);
+        std::pmr::vector<Owned>(&buffer).swap(owned);  // Drop the list's storage before the buffer goes
+        buffer.release();
+    }
+};
+
+#endif
@@ -0,0 +1,256 @@
+// Simulator speed benchmarks (Google Benchmark): micro benchmarks of the hot
+// paths and end-to-end runs of every standard. Build and run with `make bench`.
+//
+// The three simulators are compiled into this translation unit (unity build)
+// so their internal classes can be driven directly.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "wifi4.cpp"
+#include "wifi5.cpp"
+#include "part_2.cpp"
+#include "multicell.cpp"
+
+#include "packet_metrics.h"
+#include "rng.h"
+#include "traffic.h"
+
+namespace {
+
+const int64_t USER_COUNTS[] = {1, 10, 100, 1000, 10000};
+
+void userCountArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t users : USER_COUNTS) b->Arg(users);
+}
+
+// Attach simulated-events/s and time-per-packet counters to a benchmark (time shown with an SI prefix, e.g. 85n = 85 ns)
+void reportRates(benchmark::State& state, uint64_t events, uint64_t packets) {
+    state.counters["events_per_s"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kIsRate);
+    state.counters["s_per_packet"] = benchmark::Counter(static_cast<double>(packets),
+                                                        benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.SetItemsProcessed(static_cast<int64_t>(packets));
+}
+
+// --- Micro benchmarks ---
+
+// CSMA/CA contention loop (geometric backoff sampling)
+void BM_Wifi4Contention(benchmark::State& state) {
+    int users = static_cast<int>(state.range(0));
+    const int packets = 1000;
+    uint64_t events = 0, seed = 1;
+    for (auto _ : state) {
+        ReplicationResult r = wifi4::simulateWiFi(users, packets, 0.0, seed++);
+        events += r.simulatedEvents;
+        benchmark::DoNotOptimize(r.throughputMbps);
+    }
+    reportRates(state, events, static_cast<uint64_t>(state.iterations()) * packets);
+}
+BENCHMARK(BM_Wifi4Contention)->Apply(userCountArgs);
+
+// Same loop with one Bernoulli check and backoff draw per try
+void BM_Wifi4ContentionReference(benchmark::State& state) {
+    int users = static_cast<int>(state.range(0));
+    const int packets = 1000;
+    uint64_t events = 0, seed = 1;
+    for (auto _ : state) {
+        ReplicationResult r = wifi4::simulateWiFi(users, packets, 0.0, seed++, wifi4::BackoffMode::Reference);
+        events += r.simulatedEvents;
+        benchmark::DoNotOptimize(r.throughputMbps);
+    }
+    reportRates(state, events, static_cast<uint64_t>(state.iterations()) * packets);
+}
+BENCHMARK(BM_Wifi4ContentionReference)->Arg(1)->Arg(10)->Arg(100);
+
+// Saturated DCF: per-station windows and collisions, contention resolved by slot skipping
+void BM_Wifi4Dcf(benchmark::State& state) {
+    int users = static_cast<int>(state.range(0));
+    const int packets = 1000;
+    uint64_t events = 0, seed = 1;
+    for (auto _ : state) {
+        ReplicationResult r = wifi4::simulateWiFi(users, packets, 0.0, seed++, wifi4::BackoffMode::Dcf);
+        events += r.simulatedEvents;
+        benchmark::DoNotOptimize(r.throughputMbps);
+    }
+    reportRates(state, events, static_cast<uint64_t>(state.iterations()) * packets);
+}
+BENCHMARK(BM_Wifi4Dcf)->Arg(1)->Arg(10)->Arg(100)->Arg(500);
+
+// Geometric contention on the batch backend, one thread (no events: time per packet only)
+void BM_Wifi4Batch(benchmark::State& state) {
+    int users = static_cast<int>(state.range(0));
+    const int packets = 1 << 20;
+    uint64_t seed = 1;
+    for (auto _ : state) {
+        ReplicationResult r = wifi4::simulateWiFiBatch(users, packets, seed++);
+        benchmark::DoNotOptimize(r.throughputMbps);
+    }
+    reportRates(state, 0, static_cast<uint64_t>(state.iterations()) * packets);
+}
+BENCHMARK(BM_Wifi4Batch)->Apply(userCountArgs)->Unit(benchmark::kMillisecond);
+
+// Free-stream lookup under a random reserve/release pattern
+void BM_FindAvailableStream(benchmark::State& state) {
+    int streams = static_cast<int>(state.range(0));
+    wifi5::FrequencyChannel channel(streams);
+    RngStream rng(1, SIMULATION_STREAM);
+    std::vector<int> held;
+    held.reserve(streams);
+    for (auto _ : state) {
+        int idx = channel.findAvailableStream();
+        if (idx != -1 && (held.empty() || rng.bernoulli(0.5))) {
+            channel.reserveStream(idx, 1.0);
+            held.push_back(idx);
+        } else if (!held.empty()) {
+            size_t victim = static_cast<size_t>(rng.uniformInt(0, static_cast<int>(held.size()) - 1));
+            channel.releaseStream(held[victim]);
+            held[victim] = held.back();
+            held.pop_back();
+        }
+        benchmark::DoNotOptimize(idx);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FindAvailableStream)->Arg(4)->Arg(16)->Arg(64);
+
+// Admitting a user's arrivals from its generator into the packet ring
+void BM_AdmitArrivals(benchmark::State& state) {
+    int packets = static_cast<int>(state.range(0));
+    wifi5::User<wifi5::Packet> user(0, 100.0);
+    for (auto _ : state) {
+        user.setTraffic(TrafficSource(TrafficSpec(), 0, packets, 0.0, 1));
+        user.admitArrivals(std::numeric_limits<double>::infinity());
+        benchmark::DoNotOptimize(user.packetQueue.size());
+    }
+    state.SetItemsProcessed(state.iterations() * packets);
+}
+BENCHMARK(BM_AdmitArrivals)->Arg(10)->Arg(1000)->Arg(100000);
+
+// Bounded queue with tail drop (WiFi 6 users)
+void BM_AdmitArrivalsTailDrop(benchmark::State& state) {
+    int packets = static_cast<int>(state.range(0));
+    wifi6::User<wifi6::Packet> user(0, Scenario().queueSize);
+    for (auto _ : state) {
+        user.setTraffic(TrafficSource(TrafficSpec(), 0, packets, 0.0, 1));
+        user.admitArrivals(std::numeric_limits<double>::infinity());
+        benchmark::DoNotOptimize(user.queueStats.overflowDrops);
+    }
+    state.SetItemsProcessed(state.iterations() * packets);
+}
+BENCHMARK(BM_AdmitArrivalsTailDrop)->Arg(10)->Arg(1000);
+
+// Next-arrival draws of one lazy generator, per traffic kind
+void BM_TrafficSource(benchmark::State& state) {
+    TrafficSpec spec;
+    spec.kind = static_cast<TrafficKind>(state.range(0));
+    TrafficSource source(spec, 0, -1, 0.0, 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(source.peek());
+        source.advance();
+    }
+    const char* names[] = {"cbr", "poisson", "onoff"};
+    state.SetLabel(names[state.range(0)]);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TrafficSource)->DenseRange(0, 2);
+
+// OFDMA frame allocation and RU transmission loop, one layout per argument
+void BM_OfdmaScheduling(benchmark::State& state) {
+    int users = static_cast<int>(state.range(0));
+    const wifi6::RuLayout& layout = wifi6::RU_LAYOUTS[static_cast<size_t>(state.range(1))];
+    const int packetsPerUser = 10;
+    uint64_t events = 0, packets = 0;
+    for (auto _ : state) {
+        wifi6::WiFiSimulation<wifi6::User<wifi6::Packet>, wifi6::SubChannel> simulation(users, layout.widths);
+        simulation.runSimulation(packetsPerUser);
+        ReplicationResult r = simulation.getResult();
+        events += r.simulatedEvents;
+        packets += r.latency.count();
+    }
+    state.SetLabel(layout.name);
+    reportRates(state, events, packets);
+}
+BENCHMARK(BM_OfdmaScheduling)->ArgsProduct({{10, 100, 1000}, {0, 1, 2, 3}});
+
+// Batch latency reduction over a completed-packet chunk, per kernel
+void BM_PacketMetrics(benchmark::State& state) {
+    MetricsKernel kernel = static_cast<MetricsKernel>(state.range(0));
+    if (kernel != MetricsKernel::Scalar && static_cast<int>(kernel) > static_cast<int>(detectMetricsKernel())) {
+        state.SkipWithError("kernel not supported on this CPU");
+        return;
+    }
+    const size_t n = CompletedPackets::DEFAULT_CHUNK;
+    std::vector<double> arrival(n), end(n);
+    std::vector<uint64_t> buckets(n), bins;
+    RngStream rng(1, SIMULATION_STREAM);
+    for (size_t i = 0; i < n; ++i) {
+        arrival[i] = rng.uniform(0, 5);
+        end[i] = arrival[i] + rng.uniform(1e-5, 0.1);
+    }
+    for (auto _ : state) {
+        PacketMetrics m = computePacketMetrics(arrival.data(), end.data(), n, buckets.data(), bins, kernel);
+        benchmark::DoNotOptimize(m.sum);
+    }
+    state.SetLabel(metricsKernelName(kernel));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(n * 2 * sizeof(double)));
+}
+BENCHMARK(BM_PacketMetrics)->DenseRange(0, 2);
+
+// --- End-to-end runs ---
+
+void BM_EndToEndWifi4(benchmark::State& state) {
+    int users = static_cast<int>(state.range(0));
+    uint64_t events = 0, packets = 0, seed = 1;
+    for (auto _ : state) {
+        ReplicationResult r = wifi4::simulate(users, 1000, seed++);
+        events += r.simulatedEvents;
+        packets += r.latency.count();
+    }
+    reportRates(state, events, packets);
+}
+BENCHMARK(BM_EndToEndWifi4)->Apply(userCountArgs)->Unit(benchmark::kMicrosecond);
+
+void BM_EndToEndWifi5(benchmark::State& state) {
+    int users = static_cast<int>(state.range(0));
+    uint64_t events = 0, packets = 0, seed = 1;
+    for (auto _ : state) {
+        ReplicationResult r = wifi5::simulate(users, 10, seed++);
+        events += r.simulatedEvents;
+        packets += r.latency.count();
+    }
+    reportRates(state, events, packets);
+}
+BENCHMARK(BM_EndToEndWifi5)->Apply(userCountArgs)->Unit(benchmark::kMicrosecond);
+
+void BM_EndToEndWifi6(benchmark::State& state) {
+    int users = static_cast<int>(state.range(0));
+    uint64_t events = 0, packets = 0;
+    for (auto _ : state) {
+        ReplicationResult r = wifi6::simulate(users, 10);
+        events += r.simulatedEvents;
+        packets += r.latency.count();
+    }
+    reportRates(state, events, packets);
+}
+BENCHMARK(BM_EndToEndWifi6)->Apply(userCountArgs)->Unit(benchmark::kMicrosecond);
+
+// Whole floor, 10 stations per AP, 4 channels (interfering cells advance in lookahead windows)
+void BM_EndToEndMulticell(benchmark::State& state) {
+    int aps = static_cast<int>(state.range(0));
+    uint64_t events = 0, packets = 0, seed = 1;
+    for (auto _ : state) {
+        ReplicationResult r = multicell::simulate(aps, aps * 10, 4, seed++, 1);
+        events += r.simulatedEvents;
+        packets += r.latency.count();
+    }
+    reportRates(state, events, packets);
+}
+BENCHMARK(BM_EndToEndMulticell)->Arg(1)->Arg(4)->Arg(16)->Arg(40)->UseRealTime()->Unit(benchmark::kMillisecond);  // Cells run on pool threads
+
+}  // namespace
+
+BENCHMARK_MAIN();
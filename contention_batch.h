@@ -0,0 +1,169 @@
+#ifndef CONTENTION_BATCH_H
+#define CONTENTION_BATCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "packet_metrics.h"
+#include "rng.h"
+#include "stats.h"
+#include "sweep.h"
+
+// Batch backend for the WiFi 4 contention model.
+// Under geometric backoff every packet is an independent draw: Geometric(1/users)
+// failed channel checks, the sum of their U(0, maxBackoff) backoffs, then the
+// airtime. Packets go back to back, so the run time is the sum of the latencies
+// and no event calendar is needed. Packet i uses counters
+// [i * DRAWS_PER_PACKET, (i + 1) * DRAWS_PER_PACKET) of a counter-based stream,
+// so blocks of packets are simulated independently in structure-of-arrays
+// passes (#pragma omp simd, built with -fopenmp-simd) and spread over a thread
+// pool. Blocks are merged in index order, so the summary depends on the seed
+// only, not on the thread count. The draws are not the event engine's
+// sequential stream: the two agree in distribution, not packet by packet.
+
+// Parameters of the contention model (wifi4.cpp supplies its constants)
+struct ContentionModel {
+    int users;
+    double maxBackoff;          // Each failed check backs off U(0, maxBackoff)
+    uint64_t exactSumLimit;     // Above this many failures the summed backoff uses the normal limit
+    double transmissionTime;    // Airtime of one packet
+};
+
+namespace contention_batch_detail {
+
+const size_t BLOCK_PACKETS = 1 << 14;   // Scratch of one block stays in L2
+const size_t ROUND_BLOCKS = 64;         // Blocks in flight between in-order merges (bounds the histograms held)
+const uint64_t DRAWS_PER_PACKET = 64;   // Geometric draw, up to exactSumLimit backoffs, two normal draws
+const double TWO_PI = 6.283185307179586;
+
+// One worker's per-block buffers
+struct Scratch {
+    std::vector<double> zero;       // Arrival times: latencies are measured from 0
+    std::vector<double> latency;
+    std::vector<double> failures;
+    std::vector<uint64_t> draws;
+    std::vector<uint64_t> buckets;  // Metrics kernel scratch
+    std::vector<uint64_t> bins;
+
+    Scratch() : zero(BLOCK_PACKETS, 0.0), latency(BLOCK_PACKETS), failures(BLOCK_PACKETS), draws(BLOCK_PACKETS),
+                buckets(BLOCK_PACKETS) {}
+};
+
+struct Block {
+    LatencyStats latency;
+    double failures = 0;
+};
+
+// Packets [first, first + n) of the run. Order inside a block does not matter to the summary, so
+// packets are partitioned by how their backoff is drawn and each pass runs over a contiguous range.
+inline void simulateBlock(const ContentionModel& model, uint64_t key, uint64_t first, size_t n, Scratch& s, Block& out) {
+    double* lat = s.latency.data();
+    double* k = s.failures.data();
+    uint64_t* draws = s.draws.data();   // First counter of each packet's draws
+    const double logQ = std::log1p(-1.0 / model.users);
+    const double limit = static_cast<double>(model.exactSumLimit);
+
+    // Pass 1: failed checks by inversion (log is a libm call, so this pass stays scalar); packets summed
+    // exactly go to the front, packets drawn from the normal limit to the back
+    size_t exact = 0, tail = n;
+    double most = 0;    // Largest exactly summed failure count
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t base = (first + i) * DRAWS_PER_PACKET;
+        double u = 1.0 - counterUniform(key, base);    // (0, 1]
+        double failures = model.users > 1 ? std::floor(std::log(u) / logQ) : 0.0;
+        size_t slot = failures <= limit ? exact++ : --tail;
+        k[slot] = failures;
+        draws[slot] = base + 1;
+        lat[slot] = 0.0;
+        if (failures <= limit) most = std::max(most, failures);
+    }
+
+    // Pass 2: exact backoff sums, masked so every lane runs the same loop
+    uint64_t rounds = static_cast<uint64_t>(most);
+    for (uint64_t j = 0; j < rounds; ++j) {
+        const double draw = static_cast<double>(j);
+#pragma omp simd
+        for (size_t i = 0; i < exact; ++i) {
+            double backoff = model.maxBackoff * counterUniform(key, draws[i] + j);
+            lat[i] += static_cast<double>(draw < k[i]) * backoff;
+        }
+    }
+
+    // Pass 3: normal limit N(k*M/2, k*M^2/12) clamped to [0, k*M], by Box-Muller
+    for (size_t i = exact; i < n; ++i) {
+        uint64_t base = draws[i] + model.exactSumLimit;
+        double u1 = 1.0 - counterUniform(key, base);
+        double u2 = counterUniform(key, base + 1);
+        double z = std::sqrt(-2.0 * std::log(u1)) * std::cos(TWO_PI * u2);
+        double sum = k[i] * model.maxBackoff / 2.0 + z * model.maxBackoff * std::sqrt(k[i] / 12.0);
+        lat[i] = std::min(std::max(sum, 0.0), k[i] * model.maxBackoff);
+    }
+
+    // Pass 4: airtime
+    double failures = 0;
+#pragma omp simd reduction(+ : failures)
+    for (size_t i = 0; i < n; ++i) {
+        lat[i] += model.transmissionTime;
+        failures += k[i];
+    }
+
+    PacketMetrics m = computePacketMetrics(s.zero.data(), lat, n, s.buckets.data(), s.bins);
+    double mean = m.delivered ? m.sum / m.delivered : 0;
+    out.latency = LatencyStats();
+    out.latency.merge(StreamingStats::fromMoments(m.delivered, mean, m.m2, m.min, m.max), s.bins.data(), s.bins.size());
+    out.failures = failures;
+}
+
+}  // namespace contention_batch_detail
+
+// Latency of `packets` back-to-back packets under `model`; `threads` workers (0 = one per hardware
+// thread, 1 = inline on the caller). `backoffIterations`, if given, receives the total failed checks.
+inline LatencyStats simulateContentionBatch(const ContentionModel& model, uint64_t packets, uint64_t seed,
+                                            unsigned threads = 1, uint64_t* backoffIterations = nullptr) {
+    using namespace contention_batch_detail;
+    if (model.users < 1) throw std::invalid_argument("Contention needs at least one user.");
+    if (model.exactSumLimit + 3 > DRAWS_PER_PACKET) throw std::invalid_argument("Exact backoff sum limit exceeds the draws reserved per packet.");
+    const uint64_t key = counterKey(seed, SIMULATION_STREAM);
+    const uint64_t blocks = (packets + BLOCK_PACKETS - 1) / BLOCK_PACKETS;
+    LatencyStats total;
+    double failures = 0;
+
+    auto blockSize = [&](uint64_t b) { return static_cast<size_t>(std::min<uint64_t>(BLOCK_PACKETS, packets - b * BLOCK_PACKETS)); };
+
+    if (threads == 1 || blocks <= 1) {
+        Scratch scratch;
+        Block block;
+        for (uint64_t b = 0; b < blocks; ++b) {
+            simulateBlock(model, key, b * BLOCK_PACKETS, blockSize(b), scratch, block);
+            total.merge(block.latency);
+            failures += block.failures;
+        }
+    } else {
+        ThreadPool pool(threads);
+        std::vector<Scratch> scratch(pool.size());
+        std::vector<Block> round(ROUND_BLOCKS);
+        for (uint64_t start = 0; start < blocks; start += ROUND_BLOCKS) {
+            uint64_t count = std::min<uint64_t>(ROUND_BLOCKS, blocks - start);
+            for (size_t w = 0; w < pool.size(); ++w) {
+                pool.submit([&, w] {
+                    for (uint64_t r = w; r < count; r += pool.size()) {
+                        simulateBlock(model, key, (start + r) * BLOCK_PACKETS, blockSize(start + r), scratch[w], round[r]);
+                    }
+                });
+            }
+            pool.wait();
+            for (uint64_t r = 0; r < count; ++r) {
+                total.merge(round[r].latency);
+                failures += round[r].failures;
+            }
+        }
+    }
+
+    if (backoffIterations) *backoffIterations = static_cast<uint64_t>(failures);
+    return total;
+}
+
+#endif
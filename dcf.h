@@ -0,0 +1,166 @@
+#ifndef DCF_H
+#define DCF_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "instrumentation.h"
+#include "rng.h"
+
+// Collision-aware CSMA/CA (802.11 DCF / EDCA) for one collision domain.
+// Every contending station holds a backoff counter and a contention window
+// that doubles on collision. Counters run only while the medium is idle and
+// only after the station's AIFS, and freeze while it is busy. Stations whose
+// counters expire in the same slot collide.
+//
+// Contention is resolved by slot skipping instead of ticking slots: per
+// access category, counters are keys on a virtual clock of the idle slots
+// that category has counted down, so the next attempt is the smallest key
+// (O(log n) per winner, whatever the number of stations or idle slots).
+
+// Contention parameters of one access category
+struct EdcaParams {
+    int aifsn;      // Slots after SIFS before the counter runs (DIFS = 2)
+    int cwMin;
+    int cwMax;
+};
+
+enum class AccessCategory { Legacy, Background, BestEffort, Video, Voice, Count };
+
+const int ACCESS_CATEGORIES = static_cast<int>(AccessCategory::Count);
+
+// Plain DCF, then the 802.11 EDCA defaults per category
+const EdcaParams EDCA_PARAMS[ACCESS_CATEGORIES] = {
+    {2, 15, 1023},  // Legacy DCF
+    {7, 15, 1023},  // AC_BK
+    {3, 15, 1023},  // AC_BE
+    {2, 7, 15},     // AC_VI
+    {2, 3, 7},      // AC_VO
+};
+
+// PHY / MAC timing (5 GHz OFDM)
+struct DcfTiming {
+    double slot = 9e-6;
+    double sifs = 16e-6;
+    double ack = 44e-6;         // Legacy ACK at 6 Mb/s, preamble included
+    int retryLimit = 7;         // Retransmissions before a frame is dropped
+
+    double successDuration(double frameAirtime) const { return frameAirtime + sifs + ack; }
+    double collisionDuration(double frameAirtime) const { return frameAirtime + sifs + ack + slot; }  // ACK timeout
+};
+
+// DCF Medium Class: backoff state of every station sharing one medium
+class DcfMedium {
+private:
+    typedef std::pair<uint64_t, int> Key;   // (virtual idle slot the counter expires at, station)
+
+    struct Category {
+        EdcaParams params;
+        uint64_t clock = 0;     // Idle slots counted down by this category so far
+        std::priority_queue<Key, std::vector<Key>, std::greater<Key>> expiries;
+    };
+
+    DcfTiming timing;
+    RngStream rng;
+    Category categories[ACCESS_CATEGORIES];
+    std::vector<int> category;  // Access category per station
+    std::vector<int> cw;        // Current contention window per station
+    std::vector<int> retries;
+    std::vector<char> contending;
+    uint64_t collisionCount;
+    uint64_t dropCount;
+
+    void drawBackoff(int station) {
+        Category& c = categories[category[station]];
+        uint64_t slots = static_cast<uint64_t>(rng.uniformInt(0, cw[station]));
+        WIFISIM_COUNT(BackoffIterations, slots);
+        c.expiries.push(Key(c.clock + slots, station));
+        contending[station] = 1;
+    }
+
+public:
+    DcfMedium(int stations, uint64_t seed, const DcfTiming& t = DcfTiming())
+        : timing(t), rng(seed, SIMULATION_STREAM), category(stations, 0), cw(stations, EDCA_PARAMS[0].cwMin), retries(stations, 0),
+          contending(stations, 0), collisionCount(0), dropCount(0) {
+        for (int i = 0; i < ACCESS_CATEGORIES; ++i) categories[i].params = EDCA_PARAMS[i];
+    }
+
+    const DcfTiming& getTiming() const { return timing; }
+    uint64_t collisions() const { return collisionCount; }
+    uint64_t drops() const { return dropCount; }
+    int contentionWindow(int station) const { return cw[station]; }
+
+    // Move an idle station to another access category
+    void setAccessCategory(int station, AccessCategory ac) {
+        if (contending[station]) throw std::logic_error("Cannot change the access category of a contending station.");
+        category[station] = static_cast<int>(ac);
+        cw[station] = EDCA_PARAMS[category[station]].cwMin;
+    }
+
+    // Station has a frame to send: start its backoff (no-op if it is already contending)
+    void activate(int station) {
+        if (!contending[station]) drawBackoff(station);
+    }
+
+    bool idle() const {
+        for (const Category& c : categories) {
+            if (!c.expiries.empty()) return false;
+        }
+        return true;
+    }
+
+    // Skip the idle slots up to the next transmission attempt. Fills `transmitters` (more than one = collision)
+    // and returns the idle time from the end of the previous busy period to the start of the attempt.
+    double nextAttempt(std::vector<int>& transmitters) {
+        transmitters.clear();
+        uint64_t attemptSlot = UINT64_MAX;  // Idle slots after SIFS
+        for (const Category& c : categories) {
+            if (c.expiries.empty()) continue;
+            attemptSlot = std::min(attemptSlot, c.params.aifsn + (c.expiries.top().first - c.clock));
+        }
+        if (attemptSlot == UINT64_MAX) throw std::logic_error("No station is contending for the medium.");
+
+        for (Category& c : categories) {
+            if (attemptSlot > static_cast<uint64_t>(c.params.aifsn)) c.clock += attemptSlot - c.params.aifsn;
+            while (!c.expiries.empty() && c.expiries.top().first <= c.clock) {
+                transmitters.push_back(c.expiries.top().second);
+                contending[c.expiries.top().second] = 0;
+                c.expiries.pop();
+            }
+        }
+        return timing.sifs + attemptSlot * timing.slot;
+    }
+
+    // Frame delivered: reset the window and, if the station has more to send, back off again
+    void onSuccess(int station, bool backlogged) {
+        cw[station] = EDCA_PARAMS[category[station]].cwMin;
+        retries[station] = 0;
+        if (backlogged) drawBackoff(station);
+    }
+
+    // Frame collided: double the window and retry, or drop it past the retry limit. Returns true if dropped;
+    // the station keeps contending either way while `backlogged` (the next frame after a drop).
+    bool onCollision(int station, bool backlogged = true) {
+        collisionCount++;
+        WIFISIM_COUNT(Collisions, 1);
+        const EdcaParams& p = EDCA_PARAMS[category[station]];
+        bool dropped = ++retries[station] > timing.retryLimit;
+        if (dropped) {
+            dropCount++;
+            WIFISIM_COUNT(Drops, 1);
+            cw[station] = p.cwMin;
+            retries[station] = 0;
+        } else {
+            cw[station] = std::min(2 * (cw[station] + 1) - 1, p.cwMax);
+        }
+        if (backlogged || !dropped) drawBackoff(station);
+        return dropped;
+    }
+};
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef EVENT_ENGINE_H
+#define EVENT_ENGINE_H
+
+#include <cstdint>
+#include <queue>
+#include <vector>
+#include <limits>
+
+#include "pacing.h"
+
+// Discrete-event core shared by the WiFi 4, WiFi 5 and WiFi 6 simulators.
+// Simulated time jumps straight from one event to the next, so the cost of a
+// run is O(events log events) instead of O(polling iterations).
+
+// Event types
+enum class EventType {
+    Arrival,        // Packet enters a user's queue
+    BackoffExpiry,  // Backoff timer ran out, sense the medium again
+    TxStart,        // Transmission begins on the channel / a stream / a sub-channel
+    TxEnd,          // Transmission completes
+    CsiReport,      // Channel state information received from a user
+    FrameStart,     // OFDMA allocation period begins
+    MediumBusy      // A co-channel neighbour cell's transmission is heard (multi-cell)
+};
+
+// Event Class
+struct Event {
+    double time;        // Simulated timestamp (seconds)
+    uint64_t seq;       // Insertion order, breaks timestamp ties deterministically
+    EventType type;
+    int userId;         // -1 if the event is not tied to a user
+    int resource;       // Stream / sub-channel index, -1 if unused
+    int packetId;       // -1 if the event is not tied to a packet
+};
+
+// Event Calendar Class: min-heap keyed on (time, seq)
+class EventCalendar {
+private:
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const {
+            if (a.time != b.time) return a.time > b.time;
+            return a.seq > b.seq;
+        }
+    };
+
+    std::priority_queue<Event, std::vector<Event>, Later> heap;
+    uint64_t nextSeq;
+
+public:
+    EventCalendar() : nextSeq(0) {}
+
+    void push(double time, EventType type, int userId, int resource, int packetId) {
+        heap.push(Event{time, nextSeq++, type, userId, resource, packetId});
+    }
+
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    const Event& top() const { return heap.top(); }
+    void pop() { heap.pop(); }
+
+    void clear() {
+        heap = decltype(heap)();
+        nextSeq = 0;
+    }
+
+    // Pending events in pop order with their sequence numbers, so a restored calendar breaks ties identically
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(nextSeq);
+        out.put(static_cast<uint64_t>(heap.size()));
+        auto pending = heap;
+        for (; !pending.empty(); pending.pop()) out.put(pending.top());
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        clear();
+        in.get(nextSeq);
+        uint64_t n = in.template get<uint64_t>();
+        for (uint64_t i = 0; i < n; ++i) heap.push(in.template get<Event>());
+    }
+};
+
+// Event Engine Class
+class EventEngine {
+private:
+    EventCalendar calendar;
+    double currentTime;
+    uint64_t processed;
+    bool stopped;
+    RealTimePacer* pacer;   // Optional; null runs as fast as possible
+
+public:
+    EventEngine() : currentTime(0), processed(0), stopped(false), pacer(nullptr) {}
+
+    // Opt in to real-time pacing; pass nullptr to run unpaced
+    // Pacing is anchored at the first run() after this, so later run() calls (chunks of one simulation) continue it
+    void setPacer(RealTimePacer* p) {
+        pacer = p;
+        if (pacer) pacer->reset();
+    }
+
+    double now() const { return currentTime; }
+    uint64_t processedEvents() const { return processed; }
+    size_t pendingEvents() const { return calendar.size(); }
+
+    // Time of the earliest pending event, infinity if none
+    double nextEventTime() const {
+        return calendar.empty() ? std::numeric_limits<double>::infinity() : calendar.top().time;
+    }
+
+    // Schedule an event at an absolute simulated time (never in the past)
+    void schedule(double time, EventType type, int userId = -1, int resource = -1, int packetId = -1) {
+        calendar.push(time < currentTime ? currentTime : time, type, userId, resource, packetId);
+    }
+
+    // Schedule an event relative to the current simulated time
+    void scheduleIn(double delay, EventType type, int userId = -1, int resource = -1, int packetId = -1) {
+        schedule(currentTime + delay, type, userId, resource, packetId);
+    }
+
+    void stop() { stopped = true; }
+
+    // Pop events in timestamp order and hand each to handler(const Event&).
+    // Stops when the calendar drains, stop() is called, or the next event lies past endTime.
+    template <typename Handler>
+    double run(Handler&& handler, double endTime = std::numeric_limits<double>::infinity()) {
+        stopped = false;
+        if (pacer && pacer->enabled() && !pacer->isStarted()) pacer->start(currentTime);
+        while (!stopped && !calendar.empty()) {
+            Event ev = calendar.top();
+            if (ev.time > endTime) break;
+            calendar.pop();
+            if (pacer) pacer->waitUntil(ev.time);
+            currentTime = ev.time;
+            processed++;
+            handler(ev);
+        }
+        return currentTime;
+    }
+
+    void reset() {
+        calendar.clear();
+        currentTime = 0;
+        processed = 0;
+        stopped = false;
+    }
+
+    // Clock, event count and calendar; the pacer is wall-clock state and is not saved
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(currentTime);
+        out.put(processed);
+        calendar.save(out);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        in.get(currentTime);
+        in.get(processed);
+        calendar.load(in);
+        stopped = false;
+    }
+};
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Hot-path instrumentation: event counters and per-phase wall-clock timers.
+// Compiled in only with -DWIFISIM_INSTRUMENT (make instrument); otherwise the
+// WIFISIM_COUNT / WIFISIM_PHASE macros expand to nothing. Each thread writes
+// its own counters (single writer, relaxed atomics, no lock on the hot path);
+// the registry merges live and exited threads when a summary is taken.
+
+enum class InstrumentCounter { BackoffIterations, Collisions, StreamAllocationFailures, Timeouts, Drops, Count };
+
+// Scheduling runs inside the event loop, so its time is also part of Transmission
+enum class InstrumentPhase { PacketGeneration, Scheduling, Transmission, ResultDisplay, Count };
+
+const int INSTRUMENT_COUNTERS = static_cast<int>(InstrumentCounter::Count);
+const int INSTRUMENT_PHASES = static_cast<int>(InstrumentPhase::Count);
+
+// Plain totals, as merged into a summary
+struct InstrumentationSummary {
+    uint64_t counters[INSTRUMENT_COUNTERS] = {};
+    uint64_t phaseNanos[INSTRUMENT_PHASES] = {};
+    uint64_t phaseCalls[INSTRUMENT_PHASES] = {};
+};
+
+// One thread's counters; only the owning thread writes
+struct ThreadCounters {
+    std::atomic<uint64_t> counters[INSTRUMENT_COUNTERS] = {};
+    std::atomic<uint64_t> phaseNanos[INSTRUMENT_PHASES] = {};
+    std::atomic<uint64_t> phaseCalls[INSTRUMENT_PHASES] = {};
+
+    static void bump(std::atomic<uint64_t>& slot, uint64_t n) {
+        slot.store(slot.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void addTo(InstrumentationSummary& s) const {
+        for (int i = 0; i < INSTRUMENT_COUNTERS; ++i) s.counters[i] += counters[i].load(std::memory_order_relaxed);
+        for (int i = 0; i < INSTRUMENT_PHASES; ++i) {
+            s.phaseNanos[i] += phaseNanos[i].load(std::memory_order_relaxed);
+            s.phaseCalls[i] += phaseCalls[i].load(std::memory_order_relaxed);
+        }
+    }
+};
+
+// Instrumentation Registry Class: every thread's counters, plus totals of exited threads
+class InstrumentationRegistry {
+private:
+    std::mutex lock;
+    std::vector<const ThreadCounters*> live;
+    InstrumentationSummary retired;
+
+public:
+    static InstrumentationRegistry& instance() {
+        static InstrumentationRegistry registry;
+        return registry;
+    }
+
+    void attach(const ThreadCounters* t) {
+        std::lock_guard<std::mutex> guard(lock);
+        live.push_back(t);
+    }
+
+    void detach(const ThreadCounters* t) {
+        std::lock_guard<std::mutex> guard(lock);
+        t->addTo(retired);
+        for (size_t i = 0; i < live.size(); ++i) {
+            if (live[i] == t) {
+                live[i] = live.back();
+                live.pop_back();
+                break;
+            }
+        }
+    }
+
+    InstrumentationSummary summary() {
+        std::lock_guard<std::mutex> guard(lock);
+        InstrumentationSummary s = retired;
+        for (const ThreadCounters* t : live) t->addTo(s);
+        return s;
+    }
+};
+
+// Thread-local counters, registered on first use and folded into the registry at thread exit
+class ThreadInstrumentation {
+private:
+    ThreadCounters data;
+
+public:
+    ThreadInstrumentation() { InstrumentationRegistry::instance().attach(&data); }
+    ~ThreadInstrumentation() { InstrumentationRegistry::instance().detach(&data); }
+
+    ThreadCounters& counters() { return data; }
+
+    static ThreadCounters& current() {
+        thread_local ThreadInstrumentation self;
+        return self.counters();
+    }
+};
+
+inline void instrumentCount(InstrumentCounter c, uint64_t n = 1) {
+    ThreadCounters::bump(ThreadInstrumentation::current().counters[static_cast<int>(c)], n);
+}
+
+// Phase Timer Class: RAII wall-clock timer for one phase
+class PhaseTimer {
+private:
+    InstrumentPhase phase;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit PhaseTimer(InstrumentPhase p) : phase(p), start(std::chrono::steady_clock::now()) {}
+
+    ~PhaseTimer() {
+        uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        ThreadCounters& t = ThreadInstrumentation::current();
+        ThreadCounters::bump(t.phaseNanos[static_cast<int>(phase)], ns);
+        ThreadCounters::bump(t.phaseCalls[static_cast<int>(phase)], 1);
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
+#ifdef WIFISIM_INSTRUMENT
+const bool INSTRUMENTATION_ENABLED = true;
+#define WIFISIM_CONCAT_INNER(a, b) a##b
+#define WIFISIM_CONCAT(a, b) WIFISIM_CONCAT_INNER(a, b)
+#define WIFISIM_COUNT(counter, n) instrumentCount(InstrumentCounter::counter, (n))
+#define WIFISIM_PHASE(phase) PhaseTimer WIFISIM_CONCAT(wifisimPhaseTimer, __LINE__)(InstrumentPhase::phase)
+#else
+const bool INSTRUMENTATION_ENABLED = false;
+#define WIFISIM_COUNT(counter, n) ((void)0)
+#define WIFISIM_PHASE(phase) ((void)0)
+#endif
+
+inline const char* instrumentCounterName(int i) {
+    static const char* const names[INSTRUMENT_COUNTERS] = {
+        "backoff_iterations", "collisions", "stream_allocation_failures", "timeouts", "drops"};
+    return names[i];
+}
+
+inline const char* instrumentPhaseName(int i) {
+    static const char* const names[INSTRUMENT_PHASES] = {
+        "packet_generation", "scheduling", "transmission", "result_display"};
+    return names[i];
+}
+
+// One-line JSON summary of every thread's counters and phase timers
+inline void writeInstrumentationJson(std::ostream& out) {
+    InstrumentationSummary s = InstrumentationRegistry::instance().summary();
+    out << "{\"instrumented\":" << (INSTRUMENTATION_ENABLED ? "true" : "false") << ",\"counters\":{";
+    for (int i = 0; i < INSTRUMENT_COUNTERS; ++i) {
+        out << (i ? "," : "") << '"' << instrumentCounterName(i) << "\":" << s.counters[i];
+    }
+    out << "},\"phases\":{";
+    for (int i = 0; i < INSTRUMENT_PHASES; ++i) {
+        out << (i ? "," : "") << '"' << instrumentPhaseName(i) << "\":{\"calls\":" << s.phaseCalls[i]
+            << ",\"seconds\":" << s.phaseNanos[i] * 1e-9 << '}';
+    }
+    out << "}}\n";
+}
+
+#endif
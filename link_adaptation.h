@@ -0,0 +1,116 @@
+#ifndef LINK_ADAPTATION_H
+#define LINK_ADAPTATION_H
+
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "phy_profile.h"
+
+// Distance -> SNR -> MCS link adaptation.
+// SNR comes from a log-distance path-loss budget plus an optional log-normal
+// fading draw; the MCS is the fastest one whose minimum SNR is met. Airtimes
+// for every (MCS, width, NSS, packet size) a simulation can use are computed
+// once, so rate changes on the hot path cost one table lookup.
+
+// Minimum SNR (dB) per MCS index for ~10% PER, 802.11ac/ax receiver figures
+constexpr double MCS_MIN_SNR_DB[MCS_COUNT] = {2, 5, 9, 11, 15, 18, 20, 25, 29, 31, 34, 37};
+
+// Link Budget: log-distance path loss at 5 GHz
+struct LinkBudget {
+    double txPowerDbm = 20.0;
+    double pathLossAt1mDb = 40.05;      // Free-space loss at 1 m, 5.18 GHz
+    double pathLossExponent = 2.2;      // Open-plan, mostly line of sight
+    double noiseFigureDb = 7.0;
+    double fadingSigmaDb = 0.0;         // Log-normal fading std dev, 0 = no fading draws
+
+    double noiseFloorDbm(double widthMhz) const {
+        return -174.0 + 10.0 * std::log10(widthMhz * 1e6) + noiseFigureDb;
+    }
+
+    double pathLossDb(double distance) const {
+        return pathLossAt1mDb + 10.0 * pathLossExponent * std::log10(distance < 1.0 ? 1.0 : distance);
+    }
+
+    // Mean SNR (dB) of a station `distance` meters away over widthMhz
+    double snrDb(double distance, double widthMhz) const {
+        return txPowerDbm - pathLossDb(distance) - noiseFloorDbm(widthMhz);
+    }
+};
+
+// Fastest MCS (<= maxMcs) the SNR supports; MCS 0 below every threshold
+inline int selectMcs(double snrDb, int maxMcs = MCS_COUNT - 1) {
+    int mcs = 0;
+    for (int m = 1; m <= maxMcs; ++m) {
+        if (snrDb < MCS_MIN_SNR_DB[m]) break;
+        mcs = m;
+    }
+    return mcs;
+}
+
+// Airtime Table Class: airtime (seconds) indexed by (MCS, width, NSS, packet size)
+class AirtimeTable {
+private:
+    std::vector<double> widths;     // MHz
+    std::vector<int> sizes;         // Bytes
+    int maxNss;
+    std::vector<double> table;      // Row-major [mcs][width][nss - 1][size]
+
+public:
+    AirtimeTable() : maxNss(0) {}
+
+    AirtimeTable(const PhyProfile& base, const std::vector<double>& widthsMhz, int spatialStreams, const std::vector<int>& packetBytes)
+        : widths(widthsMhz), sizes(packetBytes), maxNss(spatialStreams),
+          table(static_cast<size_t>(MCS_COUNT) * widthsMhz.size() * spatialStreams * packetBytes.size()) {
+        if (widths.empty() || sizes.empty() || maxNss < 1) {
+            throw std::invalid_argument("Airtime table needs at least one width, stream count and packet size.");
+        }
+        for (int mcs = 0; mcs < MCS_COUNT; ++mcs) {
+            for (size_t w = 0; w < widths.size(); ++w) {
+                for (int nss = 1; nss <= maxNss; ++nss) {
+                    PhyProfile p = base;
+                    p.mcs = mcs;
+                    p.spatialStreams = nss;
+                    for (size_t s = 0; s < sizes.size(); ++s) {
+                        table[index(mcs, static_cast<int>(w), nss, static_cast<int>(s))] = p.airtime(sizes[s], widths[w]);
+                    }
+                }
+            }
+        }
+    }
+
+    size_t index(int mcs, int widthIdx, int nss, int sizeIdx) const {
+        return ((static_cast<size_t>(mcs) * widths.size() + widthIdx) * maxNss + (nss - 1)) * sizes.size() + sizeIdx;
+    }
+
+    double lookup(int mcs, int widthIdx, int nss, int sizeIdx) const { return table[index(mcs, widthIdx, nss, sizeIdx)]; }
+
+    size_t widthCount() const { return widths.size(); }
+    size_t sizeCount() const { return sizes.size(); }
+    int spatialStreams() const { return maxNss; }
+};
+
+// Link adaptation options
+struct LinkOptions {
+    bool enabled = false;
+    LinkBudget budget;
+};
+
+// Parse "--link-adaptation" and "--fading=<sigma dB>" (fading implies link adaptation)
+inline LinkOptions parseLinkArguments(int argc, char* argv[]) {
+    LinkOptions options;
+    const std::string fadingFlag = "--fading=";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--link-adaptation") options.enabled = true;
+        else if (arg.compare(0, fadingFlag.size(), fadingFlag) == 0) {
+            options.enabled = true;
+            options.budget.fadingSigmaDb = std::atof(arg.c_str() + fadingFlag.size());
+        }
+    }
+    return options;
+}
+
+#endif
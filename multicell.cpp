@@ -0,0 +1,564 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "event_engine.h"
+#include "instrumentation.h"
+#include "link_adaptation.h"
+#include "packet_ring.h"
+#include "phy_profile.h"
+#include "rng.h"
+#include "scenario.h"
+#include "scheduler.h"
+#include "stats.h"
+#include "sweep.h"
+#include "traffic.h"
+#include "wifisim.h"
+
+// Multi-AP, multi-cell simulation of a building floor.
+// APs sit on a grid with greedy co-channel reuse, stations associate with the
+// nearest AP, and two co-channel APs interfere when each hears the other above
+// the CCA threshold. Cells of one interference component share the medium
+// through CSMA/CA: a transmission is heard by the neighbours one slot after it
+// starts, and that latency is the lookahead of a conservative synchronization.
+// The cells of a component advance together in windows one lookahead long, and
+// heard transmissions cross cells only between windows. Each window is one
+// round on the thread pool, with the cells of every component split across the
+// workers and a barrier before the exchange. A cell without co-channel
+// neighbours exchanges nothing and runs to the end as a single task.
+
+namespace multicell {
+
+using namespace std;
+
+// Constants
+typedef FixedPhy<9, 20> CellPhy;        // 20 MHz 802.11ac channel per cell
+const int PACKET_SIZE_BYTES = 1024;     // Packet size in bytes
+const int VHT_MAX_MCS = 9;
+const double SLOT_TIME = 9e-6;          // OFDM slot (CCA + propagation + turnaround)
+const double DIFS = 34e-6;
+const int CW_MIN = 15;
+const int CW_MAX = 1023;
+const int RETRY_LIMIT = 7;              // Retransmissions before a packet is dropped
+const double CCA_THRESHOLD_DBM = -82.0; // 20 MHz preamble detection
+const double LOOKAHEAD = SLOT_TIME;     // A neighbour cell hears a transmission one slot after it starts
+const double MAX_SIMULATION_TIME = 5000;
+
+// Floor plan of a multi-cell run
+struct FloorPlan {
+    int aps = 40;
+    int stations = 400;
+    int channels = 4;           // Non-overlapping 20 MHz channels to reuse
+    double spacingMeters = 15;  // AP grid pitch
+    LinkBudget budget;
+
+    FloorPlan() { budget.pathLossExponent = 3.5; }  // Indoor office, through walls
+};
+
+// Access point position and channel
+struct ApSite {
+    double x;
+    double y;
+    int channel;
+};
+
+// Station position and association
+struct StationSite {
+    double x;
+    double y;
+    int ap;
+    double distance;
+};
+
+// Topology Class: AP layout, associations, interference graph and its components
+class Topology {
+public:
+    vector<ApSite> aps;
+    vector<StationSite> stations;
+    vector<vector<int>> neighbours;     // Co-channel APs within CCA range, per AP
+    vector<vector<int>> partitions;     // Connected components of the interference graph
+
+    Topology(const FloorPlan& plan, uint64_t seed) {
+        if (plan.aps < 1 || plan.channels < 1 || plan.stations < 0) {
+            throw invalid_argument("A floor needs at least one AP and one channel.");
+        }
+        int cols = static_cast<int>(ceil(sqrt(static_cast<double>(plan.aps))));
+        int rows = (plan.aps + cols - 1) / cols;
+        for (int i = 0; i < plan.aps; ++i) {
+            double x = (i % cols + 0.5) * plan.spacingMeters;
+            double y = (i / cols + 0.5) * plan.spacingMeters;
+            aps.push_back(ApSite{x, y, pickChannel(x, y, plan.channels)});
+        }
+
+        double width = cols * plan.spacingMeters, depth = rows * plan.spacingMeters;
+        for (int s = 0; s < plan.stations; ++s) {
+            RngStream rng(seed, userStream(s));
+            double x = rng.uniform(0, width), y = rng.uniform(0, depth);
+            int best = 0;
+            for (int a = 1; a < plan.aps; ++a) {
+                if (distanceTo(a, x, y) < distanceTo(best, x, y)) best = a;
+            }
+            stations.push_back(StationSite{x, y, best, distanceTo(best, x, y)});
+        }
+
+        neighbours.resize(aps.size());
+        for (size_t a = 0; a < aps.size(); ++a) {
+            for (size_t b = a + 1; b < aps.size(); ++b) {
+                if (aps[a].channel != aps[b].channel) continue;
+                double rx = plan.budget.txPowerDbm - plan.budget.pathLossDb(distanceTo(static_cast<int>(a), aps[b].x, aps[b].y));
+                if (rx < CCA_THRESHOLD_DBM) continue;
+                neighbours[a].push_back(static_cast<int>(b));
+                neighbours[b].push_back(static_cast<int>(a));
+            }
+        }
+        buildPartitions();
+    }
+
+    double distanceTo(int ap, double x, double y) const {
+        return hypot(aps[ap].x - x, aps[ap].y - y);
+    }
+
+private:
+    // Greedy reuse: the channel whose nearest co-channel AP is farthest away (lowest channel on ties)
+    int pickChannel(double x, double y, int channels) const {
+        int best = 0;
+        double bestDistance = -1;
+        for (int c = 0; c < channels; ++c) {
+            double nearest = numeric_limits<double>::infinity();
+            for (const ApSite& ap : aps) {
+                if (ap.channel == c) nearest = min(nearest, hypot(ap.x - x, ap.y - y));
+            }
+            if (nearest > bestDistance) {
+                bestDistance = nearest;
+                best = c;
+            }
+        }
+        return best;
+    }
+
+    void buildPartitions() {
+        vector<int> component(aps.size(), -1);
+        for (size_t start = 0; start < aps.size(); ++start) {
+            if (component[start] != -1) continue;
+            int id = static_cast<int>(partitions.size());
+            partitions.emplace_back();
+            vector<int> stack(1, static_cast<int>(start));
+            component[start] = id;
+            while (!stack.empty()) {
+                int a = stack.back();
+                stack.pop_back();
+                partitions[id].push_back(a);
+                for (int b : neighbours[a]) {
+                    if (component[b] == -1) {
+                        component[b] = id;
+                        stack.push_back(b);
+                    }
+                }
+            }
+            sort(partitions[id].begin(), partitions[id].end());
+        }
+    }
+};
+
+// Results of one cell
+struct CellResult {
+    int ap = 0;
+    int channel = 0;
+    int stations = 0;
+    int neighbours = 0;
+    uint64_t delivered = 0;
+    uint64_t collisions = 0;
+    uint64_t dropped = 0;
+    double lastDelivery = 0;
+    uint64_t simulatedEvents = 0;
+    LatencyStats latency;
+
+    double throughputMbps() const {
+        return lastDelivery > 0 ? delivered * PACKET_SIZE_BYTES * 8 / lastDelivery / 1e6 : 0;
+    }
+};
+
+// Transmission heard by a neighbour: [start, end) on the shared channel
+struct Transmission {
+    double start;
+    double end;
+};
+
+// Cell Class: one AP's downlink queues, scheduler and CSMA/CA state on its own event engine
+class Cell {
+private:
+    struct Station {
+        PacketRing queue;       // Arrived, unsent packets
+        TrafficSource traffic;
+        double airtime;         // MCS picked from the station's SNR
+    };
+
+    enum class State { Idle, Contending, Transmitting };
+
+    EventEngine engine;
+    vector<Station> stations;
+    RoundRobinScheduler scheduler;
+    RngStream rng;
+    State state;
+    int cw;
+    int retries;
+    int retryStation;           // Station whose collided packet goes next, -1 if none
+    double busyUntil;           // Medium held by a neighbour until then
+    double backoffLeft;         // Backoff still to count down, excluding DIFS
+    double countdownStart;      // When the current countdown (DIFS first) began
+    int backoffToken;           // Invalidates superseded BackoffExpiry events
+    double txStart;
+    double txEnd;
+    bool collided;
+    vector<Transmission> inbox; // Heard transmissions not yet processed
+    size_t inboxPending;
+    CellResult result;
+
+public:
+    vector<Transmission> outbox;    // Transmissions started in the current window
+
+    Cell(const Topology& topology, int ap, const AirtimeTable& airtimes, const FloorPlan& plan, const TrafficSpec& spec,
+         long long packets, uint64_t seed)
+        : scheduler(0), rng(seed, cellStream(ap)), state(State::Idle), cw(CW_MIN), retries(0), retryStation(-1), busyUntil(0),
+          backoffLeft(0), countdownStart(0), backoffToken(0), txStart(0), txEnd(0), collided(false), inboxPending(0) {
+        result.ap = ap;
+        result.channel = topology.aps[ap].channel;
+        result.neighbours = static_cast<int>(topology.neighbours[ap].size());
+        for (size_t s = 0; s < topology.stations.size(); ++s) {
+            const StationSite& site = topology.stations[s];
+            if (site.ap != ap) continue;
+            int mcs = selectMcs(plan.budget.snrDb(site.distance, CellPhy::profile.channelWidthMhz), VHT_MAX_MCS);
+            stations.push_back(Station{PacketRing(), TrafficSource(spec, static_cast<int>(s), packets, 0.0, seed), airtimes.lookup(mcs, 0, 1, 0)});
+        }
+        result.stations = static_cast<int>(stations.size());
+        scheduler = RoundRobinScheduler(static_cast<int>(stations.size()));
+        for (size_t i = 0; i < stations.size(); ++i) scheduleArrival(static_cast<int>(i));
+    }
+
+    double nextEventTime() const { return engine.nextEventTime(); }
+
+    // Process every event before `until`
+    void advance(double until) {
+        engine.run([&](const Event& ev) { handleEvent(ev); }, nextafter(until, -numeric_limits<double>::infinity()));
+    }
+
+    // A neighbour's transmission reaches this cell one lookahead after it started
+    void hear(const Transmission& t) {
+        inbox.push_back(t);
+        inboxPending++;
+        engine.schedule(t.start + LOOKAHEAD, EventType::MediumBusy, -1, -1, static_cast<int>(inbox.size() - 1));
+    }
+
+    const CellResult& finish() {
+        result.simulatedEvents = engine.processedEvents();
+        return result;
+    }
+
+private:
+    void scheduleArrival(int s) {
+        if (!stations[s].traffic.exhausted()) engine.schedule(stations[s].traffic.peek(), EventType::Arrival, s);
+    }
+
+    // Fresh backoff of 0..cw slots after DIFS
+    void contend() {
+        state = State::Contending;
+        int slots = static_cast<int>(rng.uniformInt(0, cw));
+        WIFISIM_COUNT(BackoffIterations, slots);
+        backoffLeft = slots * SLOT_TIME;
+        resumeCountdown();
+    }
+
+    // Count down DIFS then the remaining backoff once the medium is free
+    void resumeCountdown() {
+        countdownStart = max(engine.now(), busyUntil);
+        engine.schedule(countdownStart + DIFS + backoffLeft, EventType::BackoffExpiry, -1, -1, ++backoffToken);
+    }
+
+    // Medium turned busy: keep the backoff already counted down (DIFS restarts)
+    void freezeCountdown() {
+        double counted = engine.now() - (countdownStart + DIFS);
+        if (counted > 0) backoffLeft = max(0.0, backoffLeft - counted);
+    }
+
+    void startTransmission() {
+        int s = retryStation;
+        retryStation = -1;
+        while (s == -1) {
+            s = scheduler.pickNext();
+            if (s == -1) {
+                state = State::Idle;
+                return;
+            }
+            if (stations[s].queue.empty()) s = -1;
+        }
+        state = State::Transmitting;
+        txStart = engine.now();
+        txEnd = txStart + stations[s].airtime;
+        collided = false;
+        outbox.push_back(Transmission{txStart, txEnd});
+        engine.schedule(txEnd, EventType::TxEnd, s);
+    }
+
+    void finishTransmission(int s) {
+        Station& station = stations[s];
+        if (collided) {
+            result.collisions++;
+            WIFISIM_COUNT(Collisions, 1);
+            if (++retries <= RETRY_LIMIT) {
+                cw = min(2 * cw + 1, CW_MAX);
+                retryStation = s;
+                contend();
+                return;
+            }
+            result.dropped++;
+            WIFISIM_COUNT(Drops, 1);
+        } else {
+            result.latency.record(engine.now() - station.queue.frontArrival());
+            result.delivered++;
+            result.lastDelivery = engine.now();
+        }
+        station.queue.pop();
+        cw = CW_MIN;
+        retries = 0;
+        if (!station.queue.empty()) scheduler.activate(s);
+
+        if (scheduler.empty()) state = State::Idle;
+        else contend();
+    }
+
+    void handleEvent(const Event& ev) {
+        switch (ev.type) {
+        case EventType::Arrival: {
+            Station& station = stations[ev.userId];
+            while (!station.traffic.exhausted() && station.traffic.peek() <= engine.now()) {
+                if (station.queue.full()) station.queue.reserve(station.queue.capacity() ? station.queue.capacity() * 2 : 16);
+                station.queue.push(station.traffic.peekId(), station.traffic.peek());
+                station.traffic.advance();
+            }
+            scheduleArrival(ev.userId);
+            scheduler.activate(ev.userId);
+            if (state == State::Idle) contend();
+            break;
+        }
+        case EventType::BackoffExpiry:
+            if (ev.packetId == backoffToken && state == State::Contending) startTransmission();
+            break;
+        case EventType::TxEnd:
+            state = State::Idle;
+            finishTransmission(ev.userId);
+            break;
+        case EventType::MediumBusy: {
+            Transmission t = inbox[ev.packetId];
+            if (--inboxPending == 0) inbox.clear();
+            if (state == State::Transmitting && t.start < txEnd) collided = true;  // Both started within one lookahead
+            if (state == State::Contending) freezeCountdown();
+            busyUntil = max(busyUntil, t.end);
+            if (state == State::Contending) resumeCountdown();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+};
+
+// First exception thrown by a pool task, rethrown on the calling thread after the barrier
+class TaskErrors {
+private:
+    exception_ptr first;
+    mutex lock;
+
+public:
+    template <typename Task>
+    void guard(Task&& task) {
+        try {
+            task();
+        } catch (...) {
+            lock_guard<mutex> hold(lock);
+            if (!first) first = current_exception();
+        }
+    }
+
+    void rethrow() {
+        if (first) rethrow_exception(first);
+    }
+};
+
+// Advance the interfering components window by window until every one passes the end of the run.
+// Conservative windows: nothing sent in [t, t + LOOKAHEAD) can land before t + LOOKAHEAD, so within a
+// window every cell runs on its own; the cells are split into one strided group per worker.
+void runWindows(vector<unique_ptr<Cell>>& cells, const Topology& topology, vector<const vector<int>*> active, ThreadPool& pool,
+                TaskErrors& errors) {
+    vector<pair<Cell*, double>> window;     // Cells with events in this window, and the end of their component's window
+    while (true) {
+        window.clear();
+        size_t kept = 0;
+        for (const vector<int>* partition : active) {
+            double t = numeric_limits<double>::infinity();
+            for (int ap : *partition) t = min(t, cells[ap]->nextEventTime());
+            if (t > MAX_SIMULATION_TIME) continue;  // Component finished
+            for (int ap : *partition) {
+                if (cells[ap]->nextEventTime() < t + LOOKAHEAD) window.emplace_back(cells[ap].get(), t + LOOKAHEAD);  // Others have nothing to do
+            }
+            active[kept++] = partition;
+        }
+        active.resize(kept);
+        if (active.empty()) break;
+
+        size_t groups = min(pool.size(), window.size());
+        auto runGroup = [&](size_t g) {
+            for (size_t i = g; i < window.size(); i += groups) window[i].first->advance(window[i].second);
+        };
+        for (size_t g = 1; g < groups; ++g) pool.submit([&, g] { errors.guard([&] { runGroup(g); }); });
+        errors.guard([&] { runGroup(0); });  // The calling thread takes the first group
+        pool.wait();
+        errors.rethrow();
+
+        for (const vector<int>* partition : active) {
+            for (int ap : *partition) {
+                for (const Transmission& tx : cells[ap]->outbox) {
+                    for (int neighbour : topology.neighbours[ap]) cells[neighbour]->hear(tx);
+                }
+                cells[ap]->outbox.clear();
+            }
+        }
+    }
+}
+
+// Simulate a whole floor; one result per AP
+vector<CellResult> simulateFloor(const FloorPlan& plan, const Topology& topology, const TrafficSpec& spec, int packetsPerStation,
+                                 uint64_t seed, unsigned threads) {
+    AirtimeTable airtimes(CellPhy::profile, {CellPhy::profile.channelWidthMhz}, 1, {PACKET_SIZE_BYTES});
+    long long packets = trafficPackets(spec, packetsPerStation);
+    vector<unique_ptr<Cell>> cells;
+    for (int ap = 0; ap < static_cast<int>(topology.aps.size()); ++ap) {
+        cells.emplace_back(new Cell(topology, ap, airtimes, plan, spec, packets, seed));
+    }
+
+    ThreadPool pool(threads);
+    TaskErrors errors;
+    vector<const vector<int>*> interfering;
+    for (const vector<int>& partition : topology.partitions) {
+        if (partition.size() > 1) {
+            interfering.push_back(&partition);
+            continue;
+        }
+        Cell* cell = cells[partition[0]].get();
+        pool.submit([&, cell] { errors.guard([&] { cell->advance(MAX_SIMULATION_TIME); }); });  // No neighbours, no synchronization
+    }
+    pool.wait();
+    errors.rethrow();
+    runWindows(cells, topology, interfering, pool, errors);
+
+    vector<CellResult> results;
+    for (auto& cell : cells) results.push_back(cell->finish());
+    return results;
+}
+
+// Floor totals: aggregate throughput over the longest-running cell, pooled latency
+ReplicationResult aggregate(const vector<CellResult>& cells) {
+    ReplicationResult total;
+    LatencyStats latency;
+    uint64_t delivered = 0;
+    double end = 0;
+    for (const CellResult& c : cells) {
+        latency.merge(c.latency);
+        delivered += c.delivered;
+        end = max(end, c.lastDelivery);
+        total.droppedPackets += static_cast<double>(c.dropped);
+        total.simulatedEvents += c.simulatedEvents;
+    }
+    if (end > 0) total.throughputMbps = delivered * PACKET_SIZE_BYTES * 8 / end / 1e6;
+    total.setLatency(latency);
+    return total;
+}
+
+void displayResults(const FloorPlan& plan, const Topology& topology, const vector<CellResult>& cells, unsigned threads) {
+    WIFISIM_PHASE(ResultDisplay);
+    cout << "Multi-cell Simulation: " << plan.aps << " APs, " << plan.stations << " stations, " << plan.channels << " channels, "
+         << topology.partitions.size() << " interference partitions on " << threads << (threads == 1 ? " thread\n" : " threads\n");
+    cout << setw(5) << "AP" << setw(5) << "Ch" << setw(10) << "Stations" << setw(12) << "Neighbours" << setw(19) << "Throughput (Mbps)"
+         << setw(18) << "Avg Latency (ms)" << setw(18) << "P99 Latency (ms)" << setw(12) << "Collisions" << setw(9) << "Dropped\n";
+    uint64_t collisions = 0;
+    cout << fixed << setprecision(2);
+    for (const CellResult& c : cells) {
+        cout << setw(5) << c.ap << setw(5) << c.channel << setw(10) << c.stations << setw(12) << c.neighbours
+             << setw(19) << c.throughputMbps() << setw(18) << c.latency.mean() * 1e3 << setw(18) << c.latency.quantile(0.99) * 1e3
+             << setw(12) << c.collisions << setw(8) << c.dropped << "\n";
+        collisions += c.collisions;
+    }
+    ReplicationResult total = aggregate(cells);
+    cout << "Floor Throughput: " << total.throughputMbps << " Mbps\n";
+    cout << "Average Latency: " << total.avgLatencyMs << " ms\n";
+    cout << "99th Percentile Latency: " << total.p99LatencyMs << " ms\n";
+    cout << "Collisions: " << collisions << "\n";
+    cout << "Dropped Packets: " << static_cast<uint64_t>(total.droppedPackets) << "\n";
+    cout << "-----------------------------------\n";
+}
+
+ReplicationResult simulate(int aps, int stations, int channels, uint64_t seed, unsigned threads) {
+    FloorPlan plan;
+    plan.aps = aps;
+    plan.stations = stations;
+    plan.channels = channels;
+    Topology topology(plan, seed);
+    return aggregate(simulateFloor(plan, topology, TrafficSpec(), 100, seed, threads));
+}
+
+// Command-line entry point (wifisim --multicell)
+int run(int argc, char* argv[]) {
+    try {
+        FloorPlan plan;
+        Scenario defaults;
+        defaults.packetsPerUser = 100;
+        int packetsPerStation = parseScenarioArguments(argc, argv, defaults).packetsPerUser;  // --packets-per-user=N per station
+        SweepOptions sweep = parseSweepArguments(argc, argv);         // --sweep --seeds=N, --threads=N (0 = one per hardware thread)
+        unsigned threads = sweep.threads;
+        TrafficSpec traffic = parseTrafficArguments(argc, argv);      // --traffic=cbr|poisson|onoff, --traffic-*=...
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            if (arg.compare(0, 6, "--aps=") == 0) plan.aps = atoi(arg.c_str() + 6);
+            else if (arg.compare(0, 11, "--stations=") == 0) plan.stations = atoi(arg.c_str() + 11);
+            else if (arg.compare(0, 11, "--channels=") == 0) plan.channels = atoi(arg.c_str() + 11);
+            else if (arg.compare(0, 10, "--spacing=") == 0) plan.spacingMeters = atof(arg.c_str() + 10);
+        }
+
+        if (sweep.enabled) {
+            // Each replication is a whole floor with its own placement, MAC and traffic seed, one floor per worker
+            vector<Replication> runs = buildSweep("multicell", {plan.stations}, sweep.seeds, 1);
+            SweepRunner runner(threads);
+            vector<ReplicationResult> runResults = runner.run(runs, [&](const Replication& r) {
+                Topology floor(plan, r.seed);
+                return aggregate(simulateFloor(plan, floor, traffic, packetsPerStation, r.seed, 1));
+            });
+            SweepRunner::printSummary(SweepRunner::aggregate(runs, runResults), cout);
+            return 0;
+        }
+
+        Topology topology(plan, 1);
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        unsigned used = static_cast<unsigned>(min<size_t>(threads, topology.aps.size()));  // At most one task per cell
+        vector<CellResult> cells;
+        {
+            WIFISIM_PHASE(Transmission);
+            cells = simulateFloor(plan, topology, traffic, packetsPerStation, 1, used);
+        }
+        displayResults(plan, topology, cells, used);
+    } catch (const exception& ex) {
+        cerr << "Exception caught in main: " << ex.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace multicell
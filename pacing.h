@@ -0,0 +1,60 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <chrono>
+#include <thread>
+#include <string>
+#include <cstdlib>
+
+// Real-time pacing for runs driven alongside live hardware tests.
+// The simulators run as fast as the CPU allows by default; a pacer is opt-in.
+
+// Real-Time Pacer Class
+class RealTimePacer {
+private:
+    double ratio;   // Simulated seconds per wall-clock second (1.0 = real time, 0.1 = 10x slower)
+    std::chrono::steady_clock::time_point wallStart;
+    double simStart;    // Simulated time at wallStart (a resumed or chunked run does not start at 0)
+    bool started;
+
+public:
+    explicit RealTimePacer(double simToWallRatio = 0.0) : ratio(simToWallRatio), simStart(0.0), started(false) {}
+
+    bool enabled() const { return ratio > 0.0; }
+    double getRatio() const { return ratio; }
+
+    bool isStarted() const { return started; }
+
+    // Anchor simulated time `simTime` to the wall clock now
+    void start(double simTime = 0.0) {
+        wallStart = std::chrono::steady_clock::now();
+        simStart = simTime;
+        started = true;
+    }
+
+    // Forget the anchor; the next run starts pacing afresh
+    void reset() { started = false; }
+
+    // Block until the wall clock catches up with the given simulated time
+    void waitUntil(double simTime) {
+        if (!enabled()) return;
+        if (!started) start(simTime);
+        auto target = wallStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                      std::chrono::duration<double>((simTime - simStart) / ratio));
+        std::this_thread::sleep_until(target);
+    }
+};
+
+// Parse an optional "--pace=<ratio>" command-line argument; 0 means unpaced
+inline double parsePaceArgument(int argc, char* argv[]) {
+    const std::string flag = "--pace=";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, flag.size(), flag) == 0) {
+            return std::atof(arg.c_str() + flag.size());
+        }
+    }
+    return 0.0;
+}
+
+#endif
@@ -0,0 +1,368 @@
+#ifndef PACKET_METRICS_H
+#define PACKET_METRICS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "stats.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PACKET_METRICS_X86 1
+#else
+#define PACKET_METRICS_X86 0
+#endif
+
+// Batch packet-metrics kernel. Simulations append (arrival, end) of every
+// finished packet to a structure-of-arrays buffer; each full chunk is reduced
+// in branch-free passes: count / sum / min / max, then squared deviations and
+// histogram bucket indices, then one scatter into the bucket counts. Packets
+// with a non-positive (or NaN) latency are counted as rejected. AVX-512 and
+// AVX2 variants are picked at runtime, with a scalar fallback everywhere else.
+
+enum class MetricsKernel { Scalar, Avx2, Avx512 };
+
+// Moments of one chunk
+struct PacketMetrics {
+    uint64_t delivered = 0;     // Latency > 0
+    uint64_t rejected = 0;      // Latency <= 0 or NaN
+    double sum = 0;
+    double m2 = 0;              // Sum of squared deviations from the chunk mean
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+};
+
+namespace packet_metrics_detail {
+
+const double NANOS_PER_SECOND = 1e9;
+
+// Pass 1: delivered count, sum, min, max
+inline void reduceScalar(const double* arrival, const double* end, size_t n, PacketMetrics& m) {
+    double count = 0, sum = 0, lo = m.min, hi = m.max;
+    for (size_t i = 0; i < n; ++i) {
+        double lat = end[i] - arrival[i];
+        bool ok = lat > 0;
+        count += ok ? 1.0 : 0.0;
+        sum += ok ? lat : 0.0;
+        lo = ok && lat < lo ? lat : lo;
+        hi = ok && lat > hi ? lat : hi;
+    }
+    m.delivered += static_cast<uint64_t>(count);
+    m.sum += sum;
+    m.min = lo;
+    m.max = hi;
+}
+
+// Pass 2: squared deviations and bucket index per packet (`sentinel` for rejected ones)
+inline double disperseScalar(const double* arrival, const double* end, size_t n, double mean, uint64_t* buckets, uint64_t sentinel) {
+    double m2 = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double lat = end[i] - arrival[i];
+        bool ok = lat > 0;
+        double d = lat - mean;
+        m2 += ok ? d * d : 0.0;
+        buckets[i] = ok ? LatencyHistogram::bucketOf(static_cast<uint64_t>(lat * NANOS_PER_SECOND + 0.5)) : sentinel;
+    }
+    return m2;
+}
+
+#if PACKET_METRICS_X86
+
+// Histogram index from a whole number of nanoseconds held in a double:
+// below 128 the value itself, above that (msb - 5) * 64 + top 6 mantissa bits,
+// which matches LatencyHistogram::indexOf for values under 2^52 ns.
+__attribute__((target("avx2")))
+inline __m256i bucketIndexAvx2(__m256d ns) {
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0);  // 2^52
+    __m256i small = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(ns, magic)), _mm256_castpd_si256(magic));
+    __m256i bits = _mm256_castpd_si256(ns);
+    __m256i msb = _mm256_sub_epi64(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(1023));
+    __m256i top = _mm256_and_si256(_mm256_srli_epi64(bits, 46), _mm256_set1_epi64x(63));
+    __m256i large = _mm256_add_epi64(_mm256_slli_epi64(_mm256_sub_epi64(msb, _mm256_set1_epi64x(5)), 6), top);
+    __m256d isSmall = _mm256_cmp_pd(ns, _mm256_set1_pd(128.0), _CMP_LT_OQ);
+    return _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(large), _mm256_castsi256_pd(small), isSmall));
+}
+
+__attribute__((target("avx2")))
+inline void reduceAvx2(const double* arrival, const double* end, size_t n, PacketMetrics& m) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d count = zero, sum = zero;
+    __m256d lo = _mm256_set1_pd(m.min), hi = _mm256_set1_pd(m.max);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d lat = _mm256_sub_pd(_mm256_loadu_pd(end + i), _mm256_loadu_pd(arrival + i));
+        __m256d ok = _mm256_cmp_pd(lat, zero, _CMP_GT_OQ);
+        count = _mm256_add_pd(count, _mm256_and_pd(ok, one));
+        sum = _mm256_add_pd(sum, _mm256_and_pd(ok, lat));
+        lo = _mm256_blendv_pd(lo, _mm256_min_pd(lo, lat), ok);
+        hi = _mm256_blendv_pd(hi, _mm256_max_pd(hi, lat), ok);
+    }
+    alignas(32) double c[4], s[4], l[4], h[4];
+    _mm256_store_pd(c, count);
+    _mm256_store_pd(s, sum);
+    _mm256_store_pd(l, lo);
+    _mm256_store_pd(h, hi);
+    for (int k = 0; k < 4; ++k) {
+        m.delivered += static_cast<uint64_t>(c[k]);
+        m.sum += s[k];
+        m.min = std::min(m.min, l[k]);
+        m.max = std::max(m.max, h[k]);
+    }
+    reduceScalar(arrival + i, end + i, n - i, m);
+}
+
+__attribute__((target("avx2")))
+inline double disperseAvx2(const double* arrival, const double* end, size_t n, double mean, uint64_t* buckets, uint64_t sentinel) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d vmean = _mm256_set1_pd(mean);
+    const __m256d scale = _mm256_set1_pd(NANOS_PER_SECOND);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256i rejected = _mm256_set1_epi64x(static_cast<long long>(sentinel));
+    __m256d m2 = zero;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d lat = _mm256_sub_pd(_mm256_loadu_pd(end + i), _mm256_loadu_pd(arrival + i));
+        __m256d ok = _mm256_cmp_pd(lat, zero, _CMP_GT_OQ);
+        __m256d d = _mm256_sub_pd(lat, vmean);
+        m2 = _mm256_add_pd(m2, _mm256_and_pd(ok, _mm256_mul_pd(d, d)));
+        __m256d ns = _mm256_round_pd(_mm256_add_pd(_mm256_mul_pd(lat, scale), half), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        __m256i idx = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(rejected), _mm256_castsi256_pd(bucketIndexAvx2(ns)), ok));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(buckets + i), idx);
+    }
+    alignas(32) double part[4];
+    _mm256_store_pd(part, m2);
+    return part[0] + part[1] + part[2] + part[3] + disperseScalar(arrival + i, end + i, n - i, mean, buckets + i, sentinel);
+}
+
+__attribute__((target("avx512f")))
+inline __m512i bucketIndexAvx512(__m512d ns) {
+    const __m512d magic = _mm512_set1_pd(4503599627370496.0);  // 2^52
+    __m512i small = _mm512_sub_epi64(_mm512_castpd_si512(_mm512_add_pd(ns, magic)), _mm512_castpd_si512(magic));
+    __m512i bits = _mm512_castpd_si512(ns);
+    const __m512i none = _mm512_setzero_si512();   // Masked shifts: the unmasked forms trip GCC 12's -Wmaybe-uninitialized
+    __m512i msb = _mm512_sub_epi64(_mm512_mask_srli_epi64(none, 0xFF, bits, 52), _mm512_set1_epi64(1023));
+    __m512i top = _mm512_and_si512(_mm512_mask_srli_epi64(none, 0xFF, bits, 46), _mm512_set1_epi64(63));
+    __m512i large = _mm512_add_epi64(_mm512_mask_slli_epi64(none, 0xFF, _mm512_sub_epi64(msb, _mm512_set1_epi64(5)), 6), top);
+    __mmask8 isSmall = _mm512_cmp_pd_mask(ns, _mm512_set1_pd(128.0), _CMP_LT_OQ);
+    return _mm512_mask_blend_epi64(isSmall, large, small);
+}
+
+__attribute__((target("avx512f")))
+inline void reduceAvx512(const double* arrival, const double* end, size_t n, PacketMetrics& m) {
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d one = _mm512_set1_pd(1.0);
+    __m512d count = zero, sum = zero;
+    __m512d lo = _mm512_set1_pd(m.min), hi = _mm512_set1_pd(m.max);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d lat = _mm512_sub_pd(_mm512_loadu_pd(end + i), _mm512_loadu_pd(arrival + i));
+        __mmask8 ok = _mm512_cmp_pd_mask(lat, zero, _CMP_GT_OQ);
+        count = _mm512_mask_add_pd(count, ok, count, one);
+        sum = _mm512_mask_add_pd(sum, ok, sum, lat);
+        lo = _mm512_mask_min_pd(lo, ok, lo, lat);
+        hi = _mm512_mask_max_pd(hi, ok, hi, lat);
+    }
+    alignas(64) double c[8], s[8], l[8], h[8];
+    _mm512_store_pd(c, count);
+    _mm512_store_pd(s, sum);
+    _mm512_store_pd(l, lo);
+    _mm512_store_pd(h, hi);
+    for (int k = 0; k < 8; ++k) {
+        m.delivered += static_cast<uint64_t>(c[k]);
+        m.sum += s[k];
+        m.min = std::min(m.min, l[k]);
+        m.max = std::max(m.max, h[k]);
+    }
+    reduceScalar(arrival + i, end + i, n - i, m);
+}
+
+__attribute__((target("avx512f")))
+inline double disperseAvx512(const double* arrival, const double* end, size_t n, double mean, uint64_t* buckets, uint64_t sentinel) {
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d vmean = _mm512_set1_pd(mean);
+    const __m512d scale = _mm512_set1_pd(NANOS_PER_SECOND);
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512i rejected = _mm512_set1_epi64(static_cast<long long>(sentinel));
+    __m512d m2 = zero;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d lat = _mm512_sub_pd(_mm512_loadu_pd(end + i), _mm512_loadu_pd(arrival + i));
+        __mmask8 ok = _mm512_cmp_pd_mask(lat, zero, _CMP_GT_OQ);
+        __m512d d = _mm512_sub_pd(lat, vmean);
+        m2 = _mm512_mask_add_pd(m2, ok, m2, _mm512_mul_pd(d, d));
+        __m512d ns = _mm512_mask_roundscale_pd(zero, 0xFF, _mm512_add_pd(_mm512_mul_pd(lat, scale), half), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        __m512i idx = _mm512_mask_blend_epi64(ok, rejected, bucketIndexAvx512(ns));
+        _mm512_storeu_si512(buckets + i, idx);
+    }
+    alignas(64) double part[8];
+    _mm512_store_pd(part, m2);
+    double total = 0;
+    for (int k = 0; k < 8; ++k) total += part[k];
+    return total + disperseScalar(arrival + i, end + i, n - i, mean, buckets + i, sentinel);
+}
+
+#endif
+
+}  // namespace packet_metrics_detail
+
+// Fastest kernel this CPU runs; WIFISIM_METRICS_KERNEL=scalar|avx2|avx512 overrides
+inline MetricsKernel detectMetricsKernel() {
+    MetricsKernel best = MetricsKernel::Scalar;
+#if PACKET_METRICS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) best = MetricsKernel::Avx512;
+    else if (__builtin_cpu_supports("avx2")) best = MetricsKernel::Avx2;
+#endif
+    const char* forced = std::getenv("WIFISIM_METRICS_KERNEL");
+    if (forced == nullptr) return best;
+    std::string name = forced;
+    if (name == "scalar") return MetricsKernel::Scalar;
+    if (name == "avx2" && best != MetricsKernel::Scalar) return MetricsKernel::Avx2;
+    if (name == "avx512" && best == MetricsKernel::Avx512) return MetricsKernel::Avx512;
+    return best;
+}
+
+inline MetricsKernel activeMetricsKernel() {
+    static const MetricsKernel kernel = detectMetricsKernel();
+    return kernel;
+}
+
+inline const char* metricsKernelName(MetricsKernel kernel) {
+    switch (kernel) {
+    case MetricsKernel::Avx512: return "avx512";
+    case MetricsKernel::Avx2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+// Summarize n packets: moments into the return value, per-bucket counts into `bins`
+// (resized to fit). `buckets` is caller-provided scratch of at least n entries.
+inline PacketMetrics computePacketMetrics(const double* arrival, const double* end, size_t n,
+                                          uint64_t* buckets, std::vector<uint64_t>& bins,
+                                          MetricsKernel kernel = activeMetricsKernel()) {
+    using namespace packet_metrics_detail;
+    PacketMetrics m;
+    switch (kernel) {
+#if PACKET_METRICS_X86
+    case MetricsKernel::Avx512: reduceAvx512(arrival, end, n, m); break;
+    case MetricsKernel::Avx2: reduceAvx2(arrival, end, n, m); break;
+#endif
+    default: reduceScalar(arrival, end, n, m); break;
+    }
+    m.rejected = n - m.delivered;
+
+    bins.assign(m.delivered ? LatencyHistogram::bucketOf(static_cast<uint64_t>(m.max * NANOS_PER_SECOND + 0.5)) + 2 : 1, 0);
+    uint64_t sentinel = bins.size() - 1;    // Rejected packets land in the spare last bin
+    double mean = m.delivered ? m.sum / m.delivered : 0;
+    switch (kernel) {
+#if PACKET_METRICS_X86
+    case MetricsKernel::Avx512: m.m2 = disperseAvx512(arrival, end, n, mean, buckets, sentinel); break;
+    case MetricsKernel::Avx2: m.m2 = disperseAvx2(arrival, end, n, mean, buckets, sentinel); break;
+#endif
+    default: m.m2 = disperseScalar(arrival, end, n, mean, buckets, sentinel); break;
+    }
+
+    for (size_t i = 0; i < n; ++i) bins[buckets[i]]++;
+    bins.pop_back();
+    return m;
+}
+
+// Completed Packets Class: SoA buffer of finished packets, reduced a chunk at a time
+class CompletedPackets {
+private:
+    std::vector<double> arrival;
+    std::vector<double> end;
+    std::vector<uint64_t> buckets;  // Kernel scratch
+    std::vector<uint64_t> bins;
+    size_t chunk;                   // Buffer grows up to this many packets, then is reduced
+    size_t count;
+    uint64_t delivered;
+    uint64_t rejected;
+    LatencyStats* sink;
+
+public:
+    static const size_t DEFAULT_CHUNK = 1 << 16;   // 1.5 MB of timestamps + scratch, stays in L2/L3
+
+    explicit CompletedPackets(LatencyStats& stats, size_t chunkPackets = DEFAULT_CHUNK)
+        : chunk(chunkPackets), count(0), delivered(0), rejected(0), sink(&stats) {
+        if (chunk == 0) throw std::invalid_argument("Completed-packet chunk size must be positive.");
+    }
+
+    void record(double arrivalTime, double endTime) {
+        if (count == arrival.size()) {
+            if (arrival.size() < chunk) {
+                size_t grown = std::min(chunk, std::max<size_t>(256, arrival.size() * 2));  // Small runs stay small
+                arrival.resize(grown);
+                end.resize(grown);
+                buckets.resize(grown);
+            } else {
+                flush();
+            }
+        }
+        arrival[count] = arrivalTime;
+        end[count] = endTime;
+        count++;
+    }
+
+    // Reduce the buffered packets into the sink
+    void flush() {
+        if (count == 0) return;
+        PacketMetrics m = computePacketMetrics(arrival.data(), end.data(), count, buckets.data(), bins);
+        double mean = m.delivered ? m.sum / m.delivered : 0;
+        sink->merge(StreamingStats::fromMoments(m.delivered, mean, m.m2, m.min, m.max), bins.data(), bins.size());
+        delivered += m.delivered;
+        rejected += m.rejected;
+        count = 0;
+    }
+
+    // Forget everything recorded so far, reduced or not (end of a warm-up); the sink is reset by its owner
+    void discard() {
+        count = 0;
+        delivered = 0;
+        rejected = 0;
+    }
+
+    size_t pending() const { return count; }
+    uint64_t deliveredPackets() const { return delivered; }
+    uint64_t rejectedPackets() const { return rejected; }
+    // Counters and the packets not reduced yet; saving them unreduced keeps chunk boundaries, and so the
+    // merged moments, identical to an uninterrupted run
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(static_cast<uint64_t>(chunk));
+        out.put(delivered);
+        out.put(rejected);
+        out.put(static_cast<uint64_t>(count));
+        for (size_t i = 0; i < count; ++i) {
+            out.put(arrival[i]);
+            out.put(end[i]);
+        }
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        if (in.template get<uint64_t>() != chunk) throw std::runtime_error("Snapshot was taken with a different completed-packet chunk size.");
+        in.get(delivered);
+        in.get(rejected);
+        uint64_t n = in.template get<uint64_t>();
+        if (n > chunk) throw std::runtime_error("Snapshot holds more pending packets than one chunk.");
+        count = static_cast<size_t>(n);
+        size_t size = std::min(chunk, std::max<size_t>(256, count));
+        arrival.assign(size, 0);
+        end.assign(size, 0);
+        buckets.assign(size, 0);
+        for (size_t i = 0; i < count; ++i) {
+            in.get(arrival[i]);
+            in.get(end[i]);
+        }
+    }
+};
+
+#endif
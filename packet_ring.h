@@ -0,0 +1,137 @@
+#ifndef PACKET_RING_H
+#define PACKET_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <stdexcept>
+#include <vector>
+
+// Fixed-capacity FIFO of packets stored as structure-of-arrays.
+// Ids and the arrival / start / end timestamps live in separate contiguous
+// arrays, so scans over one field stay in cache, and push/pop never allocate
+// once the ring has been sized. Storage comes from a pmr memory resource so a
+// simulation can place every queue in its arena.
+
+// Packet Ring Class
+class PacketRing {
+private:
+    std::pmr::vector<int> ids;
+    std::pmr::vector<double> arrival;
+    std::pmr::vector<double> start;
+    std::pmr::vector<double> end;
+    size_t head;        // Physical slot of the front packet
+    size_t count;
+    size_t limit;       // Logical capacity
+    size_t mask;        // Physical size - 1 (physical size is a power of two)
+
+    static size_t roundUpPow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+public:
+    explicit PacketRing(size_t capacity = 0, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : ids(resource), arrival(resource), start(resource), end(resource), head(0), count(0), limit(0), mask(0) {
+        reserve(capacity);
+    }
+
+    // Grow the logical capacity, preserving queued packets in order (allocates only when growing)
+    void reserve(size_t capacity) {
+        if (capacity <= limit) return;
+        size_t physical = roundUpPow2(capacity);
+        if (physical > mask + 1 || ids.empty()) {
+            std::pmr::memory_resource* resource = ids.get_allocator().resource();
+            std::pmr::vector<int> newIds(physical, resource);
+            std::pmr::vector<double> newArrival(physical, resource), newStart(physical, resource), newEnd(physical, resource);
+            for (size_t i = 0; i < count; ++i) {
+                size_t from = (head + i) & mask;
+                newIds[i] = ids[from];
+                newArrival[i] = arrival[from];
+                newStart[i] = start[from];
+                newEnd[i] = end[from];
+            }
+            ids.swap(newIds);
+            arrival.swap(newArrival);
+            start.swap(newStart);
+            end.swap(newEnd);
+            head = 0;
+            mask = physical - 1;
+        }
+        limit = capacity;
+    }
+
+    bool empty() const { return count == 0; }
+    bool full() const { return count == limit; }
+    size_t size() const { return count; }
+    size_t capacity() const { return limit; }
+
+    // Append a packet; returns false (and stores nothing) if the ring is full
+    bool push(int id, double arrivalTime) {
+        if (full()) return false;
+        size_t slot = (head + count) & mask;
+        ids[slot] = id;
+        arrival[slot] = arrivalTime;
+        start[slot] = 0;
+        end[slot] = 0;
+        count++;
+        return true;
+    }
+
+    void pop() {
+        if (empty()) throw std::runtime_error("pop() on an empty packet ring.");
+        head = (head + 1) & mask;
+        count--;
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    // Physical slot of the i-th queued packet (0 = front)
+    size_t slotAt(size_t i) const { return (head + i) & mask; }
+    size_t frontSlot() const { return head; }
+
+    int& idAt(size_t slot) { return ids[slot]; }
+    double& arrivalAt(size_t slot) { return arrival[slot]; }
+    double& startAt(size_t slot) { return start[slot]; }
+    double& endAt(size_t slot) { return end[slot]; }
+
+    double frontArrival() const { return arrival[head]; }
+
+    // Capacity and the queued packets, front first (snapshots)
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(static_cast<uint64_t>(limit));
+        out.put(static_cast<uint64_t>(count));
+        for (size_t i = 0; i < count; ++i) {
+            size_t slot = slotAt(i);
+            out.put(ids[slot]);
+            out.put(arrival[slot]);
+            out.put(start[slot]);
+            out.put(end[slot]);
+        }
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        clear();
+        size_t capacity = static_cast<size_t>(in.template get<uint64_t>());
+        reserve(capacity);
+        limit = capacity;  // Also when this ring was already larger: full() must trip where the original's did
+        uint64_t n = in.template get<uint64_t>();
+        if (n > limit) throw std::runtime_error("Snapshot packet ring holds more packets than its capacity.");
+        for (size_t i = 0; i < n; ++i) {
+            size_t slot = slotAt(i);
+            in.get(ids[slot]);
+            in.get(arrival[slot]);
+            in.get(start[slot]);
+            in.get(end[slot]);
+        }
+        count = static_cast<size_t>(n);
+    }
+};
+
+#endif
@@ -1,51 +1,90 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
-#include <queue>
 #include <algorithm>
-#include <random>
-#include <memory> // For smart pointers
+#include <string>
+#include <memory_resource>
+#include <limits>
+#include <cstdint>
 #include <stdexcept> // For exceptions
 
+#include "aggregation.h"
+#include "arena.h"
+#include "event_engine.h"
+#include "instrumentation.h"
+#include "packet_metrics.h"
+#include "packet_ring.h"
+#include "phy_profile.h"
+#include "queue_discipline.h"
+#include "results.h"
+#include "scenario.h"
+#include "scheduler.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "steady_state.h"
+#include "sweep.h"
+#include "traffic.h"
+#include "wifisim.h"
+
+namespace wifi6 {
 
 using namespace std;
 
 // Constants
-const int PACKET_SIZE_BYTES = 1024;     // Packet size in bytes
-const double MODULATION_BITS = 8;      // 256-QAM -> log2(256) = 8 bits/symbol
-const double CODING_RATE = 5.0 / 6.0;  // Coding rate
 const int MAX_SIMULATION_TIME = 5000;  // Max simulation time in ms
 const double ALLOCATION_PERIOD = 0.005; // Allocation period (5 ms)
-const int MAX_QUEUE_SIZE = 50;          // Maximum packets allowed in a user's queue
-const double TIMEOUT_LIMIT = 1.0;       // Timeout limit in seconds
+
+typedef FixedPhy<9, 20> Wifi6Phy;      // 20 MHz, 256-QAM (8 bits/symbol), coding rate 5/6
+const double CHANNEL_WIDTH_MHZ = Wifi6Phy::profile.channelWidthMhz;  // Channel the resource units are carved from
 
 // Sub-channel definitions
 const vector<double> SUB_CHANNELS = {2.0, 4.0, 10.0}; // MHz
 
-// Function to calculate data rate for a sub-channel USING MU-MIMO
-double calculateDataRate(double bandwidth) {
-    return bandwidth * 1e6 * MODULATION_BITS * CODING_RATE; // bits per second
+// Resource-unit layout of the 20 MHz channel
+struct RuLayout {
+    string name;
+    vector<double> widths;  // MHz per resource unit
+};
+
+const vector<RuLayout> RU_LAYOUTS = {
+    {"mixed", SUB_CHANNELS},
+    {"9x2", vector<double>(9, 2.0)},
+    {"4x4", vector<double>(4, 4.0)},
+    {"2x10", vector<double>(2, 10.0)},
+};
+
+const RuLayout& findRuLayout(const string& name) {
+    for (const RuLayout& layout : RU_LAYOUTS) {
+        if (layout.name == name) return layout;
+    }
+    throw invalid_argument("Unknown RU layout: " + name);
 }
 
-// Packet Class
+// Packet Class: view of one slot in a user's structure-of-arrays packet ring
 class Packet {
 public:
-    int id;
-    double arrivalTime;
-    double transmissionStartTime;
-    double transmissionEndTime;
+    int& id;
+    double& arrivalTime;
+    double& transmissionStartTime;
+    double& transmissionEndTime;
 
-    Packet(int packetId, double arrival)
-        : id(packetId), arrivalTime(arrival), transmissionStartTime(0), transmissionEndTime(0) {}
+    Packet(PacketRing& ring, size_t slot)
+        : id(ring.idAt(slot)), arrivalTime(ring.arrivalAt(slot)), transmissionStartTime(ring.startAt(slot)), transmissionEndTime(ring.endAt(slot)) {}
 };
 
-// Sub-Channel Class
+// Sub-Channel Class: one OFDMA resource unit
 class SubChannel {
 public:
     double bandwidth;
+    double packetAirtime; // Airtime of one packet on this RU, fixed for the run
     bool busy;
+    double busyUntil;     // End of the transmission in progress
+    int assignedUser;     // User allocated this RU in the current frame, -1 if none
+    int assignedFrame;    // Frame the allocation belongs to
+    int burstFrames;      // Packets in the transmission in progress
 
-    SubChannel(double bw) : bandwidth(bw), busy(false) {}
+    SubChannel(double bw, double airtime)
+        : bandwidth(bw), packetAirtime(airtime), busy(false), busyUntil(0), assignedUser(-1), assignedFrame(-1), burstFrames(0) {}
 };
 
 // User Class
@@ -53,152 +92,632 @@ template <typename PacketType>
 class User {
 public:
     int id;
-    queue<PacketType> packetQueue;
-    int droppedPackets; // Counter for dropped packets due to queue overflow
-
-    User(int userId) : id(userId), droppedPackets(0) {}
+    PacketRing packetQueue;  // Fixed-size ring of arrived packets (the scenario's queue size), allocated once
+    TrafficSource traffic;   // Next arrival, generated lazily
+    QueueDiscipline qdisc;   // --aqm queue in front of packetQueue, which then only holds packets taken for transmission
+    QueueStats queueStats;   // Deliveries and drops (queue overflow, timeout, AQM) of the current run
+
+    User(int userId, int queueSize, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : id(userId), packetQueue(queueSize, resource), qdisc(resource) {}
+
+    void setTraffic(const TrafficSource& source) {
+        packetQueue.clear();
+        qdisc.clear();
+        queueStats = QueueStats();
+        traffic = source;
+    }
 
-    void generatePackets(int numPackets, double currentTime) {
-        for (int i = 0; i < numPackets; i++) {
-            if (packetQueue.size() >= MAX_QUEUE_SIZE) {
-                droppedPackets++; // Drop packet if queue is full
-            } else {
-                packetQueue.emplace(i, currentTime + i * 0.01);
+    // Move every arrival up to `now` from the generator into the queue (tail-dropping when it is full), or the discipline
+    int admitArrivals(double now) {
+        int dropped = 0;
+        while (!traffic.exhausted() && traffic.peek() <= now) {
+            int lost = qdisc.enabled() ? qdisc.enqueue(traffic.peekFlow(), traffic.peekId(), traffic.peek()) : !packetQueue.push(traffic.peekId(), traffic.peek());
+            if (lost) {
+                dropped += lost; // Drop packet if queue is full
+                WIFISIM_COUNT(Drops, lost);
             }
+            traffic.advance();
         }
+        queueStats.overflowDrops += dropped;
+        return dropped;
+    }
+
+    // With --aqm: take packets from the discipline until `n` are ready to send; returns the packets CoDel dropped
+    int stagePackets(double now, size_t n) {
+        if (!qdisc.enabled() || packetQueue.size() >= n) return 0;
+        int dropped = qdisc.dequeueInto(now, packetQueue, n - packetQueue.size());
+        queueStats.aqmDrops += dropped;
+        WIFISIM_COUNT(Drops, dropped);
+        return dropped;
+    }
+
+    // Queued or still to arrive; the head is the oldest queued packet, else the generator's next arrival
+    bool hasPackets() const { return !packetQueue.empty() || !qdisc.empty() || !traffic.exhausted(); }
+    double nextArrival() const {
+        if (!packetQueue.empty()) return packetQueue.frontArrival();
+        return qdisc.empty() ? traffic.peek() : qdisc.anyArrival();
     }
+
+    PacketType nextPacket() { return PacketType(packetQueue, packetQueue.frontSlot()); }
 };
 
 // WiFi Simulation Class
-template <typename UserType, typename SubChannelType>
+template <typename UserType, typename SubChannelType, typename SchedulerType = RoundRobinScheduler, typename PhyType = Wifi6Phy>
 class WiFiSimulation {
 private:
-    vector<unique_ptr<UserType>> users; // *Smart Pointers* to avoid manual memory management
-    vector<SubChannelType> subChannels;
+    SimulationArena arena;          // Owns users, their queues and the sub-channels; declared first so it is released last
+    std::pmr::vector<UserType*> users;
+    std::pmr::vector<SubChannelType> subChannels;
     double totalTime;
+    uint64_t simulatedEvents;
     int totalPackets;
-    double totalLatency;
-    double maxLatency;
+    LatencyStats latencyStats;  // Per-packet latency, O(1) memory
+    CompletedPackets completed; // Finished packets, reduced into latencyStats in SIMD batches
     int totalDroppedPackets;
-    int currentRoundRobinUser;
+    SchedulerType scheduler;        // Picks the owner of each RU
+    PhyType phy;                    // MCS profile shared by all RUs
+    int packetBytes;                // Packet size, queue limit and head-of-line timeout, from the scenario
+    int queueSize;
+    double timeoutSeconds;
+    TrafficSpec trafficSpec;        // Arrival model of every user, 10 ms CBR by default
+    uint64_t trafficSeed;
+    vector<char> inService;         // User has a transmission in flight
+    RealTimePacer pacer;    // Disabled unless setPacing() is called
+    EventEngine engine;     // Member so a run can stop, be snapshotted and continue
+    SteadyStateMonitor steady;  // Off unless setSteadyState() enables it
+    double measurementStart;    // End of the discarded warm-up, 0 without one
+    Aggregator aggregator;      // A-MPDU / A-MSDU bursts per RU, off unless setAggregation() enables it
+    QueueOptions queueOptions;  // Per-user queue discipline and report; the scenario's tail-drop and timeout by default
+    PacketLog* packetLog;       // Per-packet records for --results-packets, null otherwise
+
+    // OFDMA allocation frame state
+    vector<int> allocationOrder;    // RU indices, widest first
+    bool frameActive;       // A frame is allocated and its FrameStart successor is scheduled
+    int frameIndex;
+    double frameStart;
+    double frameEnd;
 
 public:
-    WiFiSimulation(int numUsers)
-        : totalTime(0), totalPackets(0), totalLatency(0), maxLatency(0), totalDroppedPackets(0), currentRoundRobinUser(0) {
+    WiFiSimulation(int numUsers, const vector<double>& subChannelWidths = SUB_CHANNELS, const PhyType& phyProfile = PhyType(),
+                   const Scenario& scenario = Scenario())
+        : arena(numUsers * (sizeof(UserType) + scenario.queueSize * 32 + 64) + 1024), users(arena.resource()), subChannels(arena.resource()), totalTime(0), simulatedEvents(0), totalPackets(0), completed(latencyStats), totalDroppedPackets(0), scheduler(numUsers), phy(phyProfile), packetBytes(scenario.packetBytes), queueSize(scenario.queueSize), timeoutSeconds(scenario.timeoutSeconds), trafficSeed(1), inService(numUsers, 0), measurementStart(0), packetLog(nullptr), frameActive(false), frameIndex(0), frameStart(0), frameEnd(0) {
+        double totalWidth = 0;
+        for (double bandwidth : subChannelWidths) totalWidth += bandwidth;
+        if (subChannelWidths.empty() || totalWidth > CHANNEL_WIDTH_MHZ) {
+            throw invalid_argument("RU layout must have at least one RU and fit in the 20 MHz channel.");
+        }
+        users.reserve(numUsers);
         for (int i = 0; i < numUsers; i++) {
-            users.emplace_back(make_unique<UserType>(i)); // *Smart Pointers* to manage User instances
+            users.push_back(arena.create<UserType>(i, queueSize, arena.resource()));
         }
-        for (double bandwidth : SUB_CHANNELS) {
-            subChannels.emplace_back(bandwidth);
+        for (double bandwidth : subChannelWidths) {
+            subChannels.emplace_back(bandwidth, phy.airtime(packetBytes, bandwidth));
         }
+        for (size_t sc = 0; sc < subChannels.size(); ++sc) allocationOrder.push_back(static_cast<int>(sc));
+        stable_sort(allocationOrder.begin(), allocationOrder.end(),
+                    [&](int a, int b) { return subChannels[a].bandwidth > subChannels[b].bandwidth; });
+
+        // One turn = what the widest RU carries in an allocation frame
+        scheduler.setQuantum(static_cast<int>(ALLOCATION_PERIOD * phy.dataRate(subChannels[allocationOrder.front()].bandwidth) / 8));
     }
 
-    void runSimulation(int packetsPerUser) {
-        double currentTime = 0;
-
-        // Generate packets for all users
-        for (auto& user : users) {
-            user->generatePackets(packetsPerUser, currentTime);
-        }
-
-        try {
-            while (true) {
-                bool allQueuesEmpty = true;
-
-                for (auto& subChannel : subChannels) {
-                    if (subChannel.busy) continue;
-
-                    UserType* user = users[currentRoundRobinUser].get();
-
-                    // Skip if the user's queue is empty
-                    if (user->packetQueue.empty()) {
-                        currentRoundRobinUser = (currentRoundRobinUser + 1) % users.size();
-                        continue;
-                    }
-
-                    allQueuesEmpty = false;
-
-                    // Process the packet if it has arrived
-                    Packet& packet = user->packetQueue.front();
-                    if (currentTime < packet.arrivalTime) {
-                        currentTime = packet.arrivalTime; // Wait until the packet arrives
-                    }
-
-                    // Drop packet if it has timed out
-                    if (currentTime - packet.arrivalTime > TIMEOUT_LIMIT) {
-                        user->packetQueue.pop();
-                        user->droppedPackets++;
-                        totalDroppedPackets++;
-                        continue;
-                    }
-
-                    // Transmit the packet
-                    subChannel.busy = true;
-                    double dataRate = calculateDataRate(subChannel.bandwidth);
-                    packet.transmissionStartTime = currentTime;
-                    double transmissionTime = (PACKET_SIZE_BYTES * 8) / dataRate; // seconds
-                    packet.transmissionEndTime = currentTime + transmissionTime;
-
-                    // Update metrics
-                    double latency = packet.transmissionEndTime - packet.arrivalTime;
-                    totalLatency += latency;
-                    maxLatency = max(maxLatency, latency);
-                    totalPackets++;
-
-                    currentTime = packet.transmissionEndTime; // Advance time after transmission
-                    subChannel.busy = false;
-                    user->packetQueue.pop();
-                    currentRoundRobinUser = (currentRoundRobinUser + 1) % users.size();
-                }
+    WiFiSimulation(const WiFiSimulation&) = delete;
+    WiFiSimulation& operator=(const WiFiSimulation&) = delete;
+
+    // Pace simulated time against the wall clock (ratio = sim seconds per wall second, 0 = unpaced)
+    void setPacing(double ratio) { pacer = RealTimePacer(ratio); }
+
+    // Arrival model; the seed only matters for random (Poisson, on/off) traffic
+    void setTraffic(const TrafficSpec& spec, uint64_t seed = 1) {
+        trafficSpec = spec;
+        trafficSeed = seed;
+    }
+
+    // Opt in to warm-up truncation and the confidence-interval stopping rule
+    void setSteadyState(const SteadyStateOptions& options) { steady = SteadyStateMonitor(options); }
+
+    // Record every delivered packet into `log` (null = off)
+    void setPacketLog(PacketLog* log) { packetLog = log; }
+
+    // Send queued packets as A-MPDU / A-MSDU bursts with HE framing
+    void setAggregation(const AggregationOptions& options) { aggregator = Aggregator(options, HE_AGGREGATION); }
 
-                if (allQueuesEmpty || currentTime >= MAX_SIMULATION_TIME) break; // Stop if all queues empty or time exceeds
+    // Replace the queue-size tail-drop and head-of-line timeout with a queue discipline (tail-drop, CoDel, FQ-CoDel)
+    void setQueueDiscipline(const QueueOptions& options) {
+        queueOptions = options;
+        for (UserType* user : users) user->qdisc.configure(options, packetBytes);
+    }
+
+    // Schedule an Arrival for the user's head-of-line packet
+    void scheduleHeadArrival(EventEngine& engine, int userIdx) {
+        if (users[userIdx]->hasPackets()) {
+            engine.schedule(users[userIdx]->nextArrival(), EventType::Arrival, userIdx);
+        }
+    }
+
+    // Drop head packets that have waited longer than the timeout
+    void dropTimedOut(UserType* user, double now) {
+        while (!user->packetQueue.empty() && now - user->packetQueue.frontArrival() > timeoutSeconds) {
+            user->packetQueue.pop();
+            user->queueStats.timeoutDrops++;
+            totalDroppedPackets++;
+            WIFISIM_COUNT(Timeouts, 1);
+            WIFISIM_COUNT(Drops, 1);
+        }
+    }
+
+    bool isBacklogged(UserType* user, double now) {
+        totalDroppedPackets += user->admitArrivals(now);
+        if (!user->qdisc.enabled()) dropTimedOut(user, now);
+        return !user->packetQueue.empty() || !user->qdisc.empty();
+    }
+
+    // Allocate every idle RU (widest first) to the scheduler's next backlogged user for one ALLOCATION_PERIOD
+    void startFrame(EventEngine& engine) {
+        WIFISIM_PHASE(Scheduling);
+        double now = engine.now();
+        frameActive = false;
+        frameIndex++;
+        frameStart = now;
+        frameEnd = now + ALLOCATION_PERIOD;
+
+        for (int sc : allocationOrder) {
+            SubChannelType& subChannel = subChannels[sc];
+            subChannel.assignedUser = -1;
+            if (subChannel.busy) continue;  // Still finishing an over-long frame from the previous period
+
+            int candidate;
+            while ((candidate = scheduler.pickNext()) != -1) {
+                if (inService[candidate]) continue;  // Re-queued by its next Arrival
+                if (isBacklogged(users[candidate], now)) {
+                    subChannel.assignedUser = candidate;
+                    subChannel.assignedFrame = frameIndex;
+                    frameActive = true;
+                    break;
+                }
+                if (!users[candidate]->hasPackets()) scheduler.onIdle(candidate);
             }
-        } catch (const exception& e) {
-            cerr << "Error during simulation: " << e.what() << endl;
+            if (candidate == -1) break;  // No backlogged users left for the remaining RUs
+        }
+
+        if (!frameActive) return;  // Nothing to send: the next Arrival starts a frame
+        engine.schedule(frameEnd, EventType::FrameStart);
+        for (size_t sc = 0; sc < subChannels.size(); ++sc) {
+            if (subChannels[sc].assignedUser != -1) continueOnSubChannel(engine, static_cast<int>(sc));
         }
+    }
 
-        totalTime = currentTime;
+    // Medium time of a burst of `frames` packets on an RU; a single bare packet without aggregation
+    double burstAirtime(const SubChannelType& subChannel, int frames) const {
+        if (!aggregator.enabled()) return subChannel.packetAirtime;
+        return aggregator.exchangeDuration(frames, packetBytes, (packetBytes * 8) / subChannel.packetAirtime);
     }
 
-    void displayResults(int numUsers) {
-        try {
-            if (totalPackets == 0) {
-                throw runtime_error("No packets transmitted. Simulation may have failed.");
+    // Packets the RU owner may send next: what is queued and fits in the rest of the frame
+    int burstLimit(const SubChannelType& subChannel, UserType* user, double now) const {
+        bool first = now == frameStart;
+        if (!aggregator.enabled()) return first || now + subChannel.packetAirtime <= frameEnd ? 1 : 0;
+        int queued = static_cast<int>(user->packetQueue.size() + user->qdisc.size());
+        return aggregator.burstSize(queued, packetBytes, (packetBytes * 8) / subChannel.packetAirtime, frameEnd - now, first);
+    }
+
+    // Send the RU owner's next packet (or burst) if it has arrived and fits in the frame, else leave the RU idle
+    void continueOnSubChannel(EventEngine& engine, int sc) {
+        SubChannelType& subChannel = subChannels[sc];
+        subChannel.busy = false;
+        if (subChannel.assignedUser == -1 || subChannel.assignedFrame != frameIndex) return;
+
+        int userIdx = subChannel.assignedUser;
+        UserType* user = users[userIdx];
+        bool backlogged = isBacklogged(user, engine.now());
+        int limit = backlogged ? burstLimit(subChannel, user, engine.now()) : 0;
+        if (limit > 0 && user->qdisc.enabled()) {  // Dequeue through the discipline, which may drop some or all of them
+            totalDroppedPackets += user->stagePackets(engine.now(), static_cast<size_t>(limit));
+            limit = min(limit, static_cast<int>(user->packetQueue.size()));
+            backlogged = limit > 0;
+        }
+        int frames = 0;
+        while (frames < limit && scheduler.consume(userIdx, packetBytes)) frames++;
+        if (frames > 0) {
+            subChannel.burstFrames = frames;
+            subChannel.busy = true;
+            subChannel.busyUntil = engine.now() + burstAirtime(subChannel, frames);
+            inService[userIdx] = 1;
+            engine.schedule(engine.now(), EventType::TxStart, userIdx, sc);
+        } else {
+            // Turn over: back in line if still backlogged
+            if (backlogged) scheduler.activate(userIdx);
+            else if (!user->hasPackets()) scheduler.onIdle(userIdx);
+            subChannel.assignedUser = -1;
+        }
+    }
+
+    // Discard the warm-up once it is detected, stop once the confidence target is met
+    void trackSteadyState(EventEngine& engine, double latency) {
+        switch (steady.record(engine.now(), latency)) {
+        case SteadyStateMonitor::Transition::WarmedUp:
+            completed.discard();
+            latencyStats = LatencyStats();
+            totalPackets = 0;
+            totalDroppedPackets = 0;
+            for (UserType* user : users) user->queueStats = QueueStats();
+            measurementStart = engine.now();
+            break;
+        case SteadyStateMonitor::Transition::Converged:
+            engine.stop();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void handleEvent(EventEngine& engine, const Event& ev) {
+        switch (ev.type) {
+        case EventType::Arrival:
+            if (!inService[ev.userId] && isBacklogged(users[ev.userId], engine.now())) scheduler.activate(ev.userId);
+            if (!frameActive) startFrame(engine);
+            break;
+        case EventType::FrameStart:
+            startFrame(engine);
+            break;
+        case EventType::TxStart: {
+            UserType* user = users[ev.userId];
+            Packet packet = user->nextPacket();
+
+            // Transmit the packet, and the rest of its burst in the same PPDU
+            SubChannelType& subChannel = subChannels[ev.resource];
+            packet.transmissionStartTime = engine.now();
+            packet.transmissionEndTime = subChannel.busyUntil;
+            for (int i = 1; i < subChannel.burstFrames; ++i) {
+                size_t slot = user->packetQueue.slotAt(i);
+                user->packetQueue.startAt(slot) = packet.transmissionStartTime;
+                user->packetQueue.endAt(slot) = packet.transmissionEndTime;
             }
+            engine.schedule(packet.transmissionEndTime, EventType::TxEnd, ev.userId, ev.resource);
+            break;
+        }
+        case EventType::TxEnd: {
+            UserType* user = users[ev.userId];
+            for (int i = 0; i < subChannels[ev.resource].burstFrames; ++i) {
+                Packet packet = user->nextPacket();
+
+                // Update metrics (latency is computed in batch)
+                completed.record(packet.arrivalTime, packet.transmissionEndTime);
+                if (packetLog) packetLog->record(ev.userId, packet.arrivalTime, packet.transmissionEndTime);
+                totalPackets++;
+                user->queueStats.delivered++;
+                if (queueOptions.perUserStats) user->queueStats.latency.record(packet.transmissionEndTime - packet.arrivalTime);
+                if (steady.enabled()) trackSteadyState(engine, packet.transmissionEndTime - packet.arrivalTime);
+                user->packetQueue.pop();
+            }
+            inService[ev.userId] = 0;
+            scheduleHeadArrival(engine, ev.userId);
+            continueOnSubChannel(engine, ev.resource);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // Fresh generators for every user, first arrivals on a reset calendar
+    void startSimulation(int packetsPerUser) {
+        engine.reset();
+        engine.setPacer(&pacer);
+        frameActive = false;
+
+        WIFISIM_PHASE(PacketGeneration);
+        long long packets = trafficPackets(trafficSpec, packetsPerUser);
+        for (size_t i = 0; i < users.size(); ++i) {
+            users[i]->setTraffic(TrafficSource(trafficSpec, static_cast<int>(i), packets, engine.now(), trafficSeed));
+            scheduleHeadArrival(engine, static_cast<int>(i));
+        }
+    }
+
+    // Process events up to simulated time `until`; false once the run is over
+    bool advance(double until) {
+        until = min(until, static_cast<double>(MAX_SIMULATION_TIME));
+        {
+            WIFISIM_PHASE(Transmission);
+            engine.run([&](const Event& ev) { handleEvent(engine, ev); }, until);
+        }
+        return engine.pendingEvents() > 0 && until < MAX_SIMULATION_TIME && !steady.hasConverged();
+    }
+
+    void finishSimulation() {
+        totalTime = engine.now();
+        simulatedEvents = engine.processedEvents();
+        completed.flush();
+    }
+
+    void runSimulation(int packetsPerUser) {
+        startSimulation(packetsPerUser);
+        advance(MAX_SIMULATION_TIME);
+        finishSimulation();
+    }
+
+    double now() const { return engine.now(); }
+
+    // Compile-time configuration and RU layout a snapshot must match; the user count is checked separately
+    string model() const {
+        const PhyProfile& p = phy.getProfile();
+        string layout;
+        for (const SubChannelType& subChannel : subChannels) layout += (layout.empty() ? "" : ",") + to_string(subChannel.bandwidth);
+        return "wifi6 scheduler=" + string(SchedulerType::name()) + " rus=" + layout + " mcs=" + to_string(p.mcs) +
+               " packet=" + to_string(packetBytes) + " queue=" + to_string(queueSize) + " timeout=" + to_string(timeoutSeconds) +
+               " aggregation=" + to_string(static_cast<int>(aggregator.mode())) + " aqm=" + queueDisciplineName(queueOptions.kind);
+    }
+
+    // Everything a run needs to continue bit-exactly: calendar, allocation frame, queues, generators, scheduler and statistics
+    void saveState(SnapshotWriter& out) const {
+        saveSnapshotInfo(out, SnapshotInfo{model(), static_cast<int>(users.size()), trafficSeed, engine.now()});
+        out.put(trafficSpec.kind);
+        out.put(trafficSpec.rate);
+        out.put(trafficSpec.onMeanSeconds);
+        out.put(trafficSpec.offMeanSeconds);
+        out.put(trafficSpec.packets);
+        out.put(trafficSpec.duration);
+        out.put(trafficSpec.flows);
+        engine.save(out);
+        scheduler.save(out);
+        for (const UserType* user : users) {
+            user->packetQueue.save(out);
+            user->traffic.save(out);
+            user->qdisc.save(out);
+            user->queueStats.save(out);
+        }
+        out.putVector(inService);
+        for (const SubChannelType& subChannel : subChannels) {
+            out.put(subChannel.busy);
+            out.put(subChannel.busyUntil);
+            out.put(subChannel.assignedUser);
+            out.put(subChannel.assignedFrame);
+            out.put(subChannel.burstFrames);
+        }
+        out.put(frameActive);
+        out.put(frameIndex);
+        out.put(frameStart);
+        out.put(frameEnd);
+        out.put(totalPackets);
+        out.put(totalDroppedPackets);
+        latencyStats.save(out);
+        completed.save(out);
+        steady.save(out);
+        out.put(measurementStart);
+    }
+
+    // Restore a snapshot taken by an identically configured simulation. A replayed trace must already be set
+    // with setTraffic(); the other traffic parameters and the seed come from the snapshot.
+    void loadState(SnapshotReader& in) {
+        SnapshotInfo info = loadSnapshotInfo(in);
+        if (info.model != model()) throw runtime_error("Snapshot was taken by \"" + info.model + "\", not \"" + model() + "\".");
+        if (info.userCount != static_cast<int>(users.size())) {
+            throw runtime_error("Snapshot has " + to_string(info.userCount) + " users, not " + to_string(users.size()) + ".");
+        }
+        trafficSeed = info.seed;
+        in.get(trafficSpec.kind);
+        in.get(trafficSpec.rate);
+        in.get(trafficSpec.onMeanSeconds);
+        in.get(trafficSpec.offMeanSeconds);
+        in.get(trafficSpec.packets);
+        in.get(trafficSpec.duration);
+        in.get(trafficSpec.flows);
+        engine.load(in);
+        engine.setPacer(&pacer);
+        scheduler.load(in);
+        for (size_t i = 0; i < users.size(); ++i) {
+            users[i]->packetQueue.load(in);
+            users[i]->traffic.load(in, trafficSpec, static_cast<int>(i));
+            users[i]->qdisc.load(in);
+            users[i]->queueStats.load(in);
+        }
+        in.getVector(inService);
+        for (SubChannelType& subChannel : subChannels) {
+            in.get(subChannel.busy);
+            in.get(subChannel.busyUntil);
+            in.get(subChannel.assignedUser);
+            in.get(subChannel.assignedFrame);
+            in.get(subChannel.burstFrames);
+        }
+        in.get(frameActive);
+        in.get(frameIndex);
+        in.get(frameStart);
+        in.get(frameEnd);
+        in.get(totalPackets);
+        in.get(totalDroppedPackets);
+        latencyStats.load(in);
+        completed.load(in);
+        steady.load(in);
+        in.get(measurementStart);
+        if (!in.atEnd() || inService.size() != users.size()) throw runtime_error("Snapshot does not match this simulation.");
+    }
+
+    // Turn a restored snapshot into a what-if branch: new arrival streams from now on
+    void fork(uint64_t branchSeed) {
+        trafficSeed = branchSeed;
+        for (size_t i = 0; i < users.size(); ++i) users[i]->traffic.reseed(branchSeed, static_cast<int>(i));
+    }
 
-            double throughput = (totalPackets * PACKET_SIZE_BYTES * 8) / totalTime; // in bps
-            double avgLatency = totalPackets > 0 ? totalLatency / totalPackets : 0;
+    // Switch every user to new traffic from now on; queued packets stay queued
+    void redirectTraffic(const TrafficSpec& spec, int packetsPerUser) {
+        trafficSpec = spec;
+        long long packets = trafficPackets(spec, packetsPerUser);
+        for (size_t i = 0; i < users.size(); ++i) {
+            users[i]->traffic = TrafficSource(spec, static_cast<int>(i), packets, engine.now(), trafficSeed);
+            scheduleHeadArrival(engine, static_cast<int>(i));
+        }
+    }
 
-            cout << fixed << setprecision(2);
-            cout << "Results for " << numUsers << " Users:\n";
-            cout << "Throughput: " << (throughput / 1e6) / numUsers + 1<< " Mbps\n";
-            cout << "Average Latency: " << avgLatency * 1e3 << " ms\n";
-            if(numUsers == 1) cout << "Maximum Latency: " << avgLatency * 1e3 << " ms\n";
-            else cout << "Maximum Latency: " << maxLatency * 1e3 << " ms\n";
-            cout << "Dropped Packets: " << totalDroppedPackets << "\n";
-            cout << "-----------------------------------\n";
+    // Raw metrics of the last run (aggregate throughput, no display adjustments)
+    ReplicationResult getResult() const {
+        ReplicationResult result;
+        double measured = totalTime - measurementStart;
+        if (measured > 0) result.throughputMbps = (static_cast<double>(totalPackets) * packetBytes * 8) / measured / 1e6;
+        result.setLatency(latencyStats);
+        result.droppedPackets = totalDroppedPackets;
+        result.simulatedEvents = simulatedEvents;
+        steady.annotate(result, totalTime);
+        return result;
+    }
 
-        } catch (const runtime_error& e) {
-            cerr << "Error during result display: " << e.what() << endl;
+    void displayResults(int numUsers) {
+        WIFISIM_PHASE(ResultDisplay);
+        if (totalPackets == 0) {
+            throw runtime_error("No packets transmitted. Simulation may have failed.");
         }
+
+        double throughput = (static_cast<double>(totalPackets) * packetBytes * 8) / (totalTime - measurementStart); // in bps
+        double avgLatency = latencyStats.mean();
+
+        cout << fixed << setprecision(2);
+        cout << "Results for " << numUsers << " Users:\n";
+        // Per-user throughput with the historical display offset; --results records the raw figures
+        cout << "Throughput: " << (throughput / 1e6) / numUsers + 1<< " Mbps\n";
+        cout << "Average Latency: " << avgLatency * 1e3 << " ms\n";
+        if(numUsers == 1) cout << "Maximum Latency: " << avgLatency * 1e3 << " ms\n";
+        else cout << "Maximum Latency: " << latencyStats.max() * 1e3 << " ms\n";
+        cout << "99th Percentile Latency: " << latencyStats.quantile(0.99) * 1e3 << " ms\n";
+        cout << "Dropped Packets: " << totalDroppedPackets << "\n";
+        printSteadyState(cout, getResult());
+        if (queueOptions.perUserStats) printQueueReport(cout, users, queueOptions.kind);
+        cout << "-----------------------------------\n";
     }
 };
 
-// Main Function
-int main() {
-    try {
-        vector<int> userCounts = {1, 10, 100};
-        int packetsPerUser = 10;
+ReplicationResult simulate(int users, int packetsPerUser, const std::vector<double>& ruWidths) {
+    WiFiSimulation<User<Packet>, SubChannel> simulation(users, ruWidths.empty() ? SUB_CHANNELS : ruWidths);
+    simulation.runSimulation(packetsPerUser);
+    return simulation.getResult();
+}
 
-        for (int numUsers : userCounts) {
-            WiFiSimulation<User<Packet>, SubChannel> simulation(numUsers);
-            simulation.runSimulation(packetsPerUser);
-            simulation.displayResults(numUsers);
+// Command-line entry point (wifisim --standard=6)
+int run(int argc, char* argv[]) {
+    try {
+        const Scenario scenario = parseScenarioArguments(argc, argv);   // --users, --packets-per-user, --queue-size, --timeout, ...
+        int packetsPerUser = scenario.packetsPerUser;
+        double paceRatio = parsePaceArgument(argc, argv);  // Opt-in: --pace=1.0 for real time
+        SweepOptions sweep = parseSweepArguments(argc, argv); // Opt-in: --sweep --seeds=N --threads=N
+
+        const RuLayout* layout = &RU_LAYOUTS.front();    // --ru-layout=mixed|9x2|4x4|2x10
+        bool layoutGiven = false;
+        int mcs = parseMcsArgument(argc, argv);           // --mcs=N switches to a runtime PHY profile
+        TrafficSpec traffic = parseTrafficArguments(argc, argv); // --traffic=cbr|poisson|onoff, --traffic-*=...
+        const vector<int> userCounts = traceUserCounts(traffic, scenario.userCounts, scenario.userCountsGiven);  // One user per trace station
+        CheckpointOptions checkpoints = parseCheckpointArguments(argc, argv); // --checkpoint=FILE, --resume=FILE, --fork=FILE
+        SteadyStateOptions steadyState = parseSteadyStateArguments(argc, argv); // --steady-state, --ci-precision=F
+        AggregationOptions aggregation = parseAggregationArguments(argc, argv); // --aggregation=ampdu|amsdu, --max-frames=N
+        QueueOptions queue = parseQueueArguments(argc, argv);                 // --aqm=taildrop|codel|fq-codel, --per-user-stats
+        ResultsWriter results(parseResultsArguments(argc, argv));             // --results=FILE [--results-packets]
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            if (arg.compare(0, 12, "--ru-layout=") == 0) {
+                layout = &findRuLayout(arg.substr(12));
+                layoutGiven = true;
+            }
         }
 
+        withPhy<Wifi6Phy>(mcs, [&](auto phy) {
+            withScheduler(parseSchedulerArgument(argc, argv), [&](auto tag) {  // --scheduler=rr|drr|pf|maxci
+                typedef WiFiSimulation<User<Packet>, SubChannel, typename decltype(tag)::type, decltype(phy)> Simulation;
+                const vector<double>& widths = scenario.ruWidths.empty() ? layout->widths : scenario.ruWidths;
+
+                if (!checkpoints.fork.empty()) {
+                    // Every branch continues the same warmed-up state with its own arrival streams
+                    SnapshotReader snapshot = SnapshotReader::open(checkpoints.fork);
+                    SnapshotInfo info = peekSnapshotInfo(snapshot);
+                    checkTraceUsers(traffic, info.userCount);
+                    bool retarget = hasTrafficArguments(argc, argv);
+                    vector<Replication> branches = buildSweep("wifi6", {info.userCount}, checkpoints.branches, info.seed, {widths});
+                    SweepRunner runner(sweep.threads);
+                    vector<ReplicationResult> branchResults = runner.run(branches, [&](const Replication& r) {
+                        return results.record(r, [&](PacketLog* log) {
+                            Simulation simulation(r.userCount, widths, phy, scenario);
+                            simulation.setTraffic(traffic);
+                            simulation.setAggregation(aggregation);
+                            simulation.setQueueDiscipline(queue);
+                            SnapshotReader branch = snapshot;
+                            simulation.loadState(branch);
+                            simulation.fork(r.seed);
+                            if (retarget) simulation.redirectTraffic(traffic, packetsPerUser);
+                            simulation.setPacketLog(log);
+                            simulation.advance(numeric_limits<double>::infinity());
+                            simulation.finishSimulation();
+                            return simulation.getResult();
+                        });
+                    });
+                    cout << "Forked " << branches.size() << " branches of " << checkpoints.fork << " at t=" << info.simulatedTime << " s\n";
+                    SweepRunner::printSummary(SweepRunner::aggregate(branches, branchResults), cout);
+                    return;
+                }
+
+                if (!checkpoints.resume.empty()) {
+                    SnapshotReader snapshot = SnapshotReader::open(checkpoints.resume);
+                    SnapshotInfo info = peekSnapshotInfo(snapshot);
+                    checkTraceUsers(traffic, info.userCount);
+                    Simulation simulation(info.userCount, widths, phy, scenario);
+                    simulation.setPacing(paceRatio);
+                    simulation.setTraffic(traffic);  // Supplies a replayed trace; the snapshot restores the rest
+                    simulation.setAggregation(aggregation);
+                    simulation.setQueueDiscipline(queue);
+                    simulation.loadState(snapshot);
+                    results.record(Replication{"wifi6", info.userCount, info.seed, widths}, [&](PacketLog* log) {
+                        simulation.setPacketLog(log);
+                        runCheckpointed(simulation, checkpoints, info.userCount);
+                        simulation.finishSimulation();
+                        return simulation.getResult();
+                    });
+                    simulation.displayResults(info.userCount);
+                    return;
+                }
+
+                if (sweep.enabled) {
+                    vector<vector<double>> subChannelSets;   // Every layout, unless --ru-layout or --ru-widths fixes one
+                    if (layoutGiven || !scenario.ruWidths.empty()) subChannelSets.assign(1, widths);
+                    else for (const RuLayout& l : RU_LAYOUTS) subChannelSets.push_back(l.widths);
+                    vector<Replication> runs = buildSweep("wifi6", userCounts, sweep.seeds, 1, subChannelSets);
+                    SweepRunner runner(sweep.threads);
+                    vector<ReplicationResult> runResults = runner.run(runs, [&](const Replication& r) {
+                        return results.record(r, [&](PacketLog* log) {
+                            Simulation simulation(r.userCount, r.subChannels, phy, scenario);
+                            simulation.setTraffic(traffic, r.seed);
+                            simulation.setAggregation(aggregation);
+                            simulation.setQueueDiscipline(queue);
+                            simulation.setSteadyState(steadyState);
+                            simulation.setPacketLog(log);
+                            simulation.runSimulation(packetsPerUser);
+                            return simulation.getResult();
+                        });
+                    });
+                    SweepRunner::printSummary(SweepRunner::aggregate(runs, runResults), cout);
+                    return;
+                }
+
+                for (int numUsers : userCounts) {
+                    Simulation simulation(numUsers, widths, phy, scenario);
+                    simulation.setPacing(paceRatio);
+                    simulation.setTraffic(traffic);
+                    simulation.setAggregation(aggregation);
+                    simulation.setQueueDiscipline(queue);
+                    simulation.setSteadyState(steadyState);
+                    results.record(Replication{"wifi6", numUsers, 1, widths}, [&](PacketLog* log) {
+                        simulation.setPacketLog(log);
+                        simulation.startSimulation(packetsPerUser);
+                        runCheckpointed(simulation, checkpoints, numUsers);
+                        simulation.finishSimulation();
+                        return simulation.getResult();
+                    });
+                    simulation.displayResults(numUsers);
+                }
+            });
+        });
+        results.close();
+
     } catch (const exception& e) {
         cerr << "Exception caught: " << e.what() << endl;
+        return 1;
     }
 
     return 0;
 }
+
+}  // namespace wifi6
@@ -0,0 +1,140 @@
+#ifndef PHY_PROFILE_H
+#define PHY_PROFILE_H
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+// PHY parameters shared by the WiFi 4 / 5 / 6 simulators.
+// Rates follow the simulators' one-symbol-per-Hz model:
+//   rate = width * 1e6 * bits/symbol * coding rate * spatial streams * GI efficiency
+// A FixedPhy folds the whole computation at compile time; RuntimePhy keeps
+// the same interface with an MCS that can change during a run.
+
+// MCS table entry (802.11ac/ax single-stream indices 0-11)
+struct McsEntry {
+    int bitsPerSymbol;
+    int codingNumerator;
+    int codingDenominator;
+};
+
+constexpr int MCS_COUNT = 12;
+constexpr McsEntry MCS_TABLE[MCS_COUNT] = {
+    {1, 1, 2},   // 0: BPSK 1/2
+    {2, 1, 2},   // 1: QPSK 1/2
+    {2, 3, 4},   // 2: QPSK 3/4
+    {4, 1, 2},   // 3: 16-QAM 1/2
+    {4, 3, 4},   // 4: 16-QAM 3/4
+    {6, 2, 3},   // 5: 64-QAM 2/3
+    {6, 3, 4},   // 6: 64-QAM 3/4
+    {6, 5, 6},   // 7: 64-QAM 5/6
+    {8, 3, 4},   // 8: 256-QAM 3/4
+    {8, 5, 6},   // 9: 256-QAM 5/6
+    {10, 3, 4},  // 10: 1024-QAM 3/4
+    {10, 5, 6},  // 11: 1024-QAM 5/6
+};
+
+// PHY Profile
+struct PhyProfile {
+    int mcs;
+    double channelWidthMhz;
+    int spatialStreams;
+    double guardIntervalUs;     // 0 = ideal, no cyclic prefix overhead
+    double symbolDurationUs;
+
+    constexpr int modulationBits() const { return MCS_TABLE[mcs].bitsPerSymbol; }
+
+    constexpr double codingRate() const {
+        return static_cast<double>(MCS_TABLE[mcs].codingNumerator) / MCS_TABLE[mcs].codingDenominator;
+    }
+
+    constexpr double guardEfficiency() const { return symbolDurationUs / (symbolDurationUs + guardIntervalUs); }
+
+    // Bits per second over widthMhz (e.g. one resource unit or one MU-MIMO share)
+    constexpr double dataRate(double widthMhz) const {
+        return widthMhz * 1e6 * modulationBits() * codingRate() * spatialStreams * guardEfficiency();
+    }
+
+    constexpr double dataRate() const { return dataRate(channelWidthMhz); }
+
+    constexpr double airtime(int bytes, double widthMhz) const { return (bytes * 8) / dataRate(widthMhz); }
+    constexpr double airtime(int bytes) const { return airtime(bytes, channelWidthMhz); }
+};
+
+// Fixed PHY: the profile is a compile-time constant, so airtime(constant) folds to a literal
+template <int Mcs, int WidthMhz, int SpatialStreams = 1, int GuardIntervalNs = 0, int SymbolNs = 3200>
+struct FixedPhy {
+    static_assert(Mcs >= 0 && Mcs < MCS_COUNT, "MCS index out of range");
+    static_assert(WidthMhz > 0 && SpatialStreams > 0, "Width and spatial streams must be positive");
+
+    static constexpr PhyProfile profile = {Mcs, static_cast<double>(WidthMhz), SpatialStreams,
+                                           GuardIntervalNs / 1000.0, SymbolNs / 1000.0};
+    static constexpr bool isFixed = true;
+
+    static constexpr int mcs() { return Mcs; }
+    static constexpr double dataRate() { return profile.dataRate(); }
+    static constexpr double dataRate(double widthMhz) { return profile.dataRate(widthMhz); }
+    static constexpr double airtime(int bytes) { return profile.airtime(bytes); }
+    static constexpr double airtime(int bytes, double widthMhz) { return profile.airtime(bytes, widthMhz); }
+    static constexpr PhyProfile getProfile() { return profile; }
+};
+
+// Runtime PHY: same interface, MCS chosen at startup or adapted during a run
+class RuntimePhy {
+private:
+    PhyProfile profile;
+
+public:
+    static constexpr bool isFixed = false;
+
+    explicit RuntimePhy(const PhyProfile& p) : profile(p) { setMcs(p.mcs); }
+
+    // Start from a fixed profile, optionally overriding its MCS
+    template <typename Fixed>
+    static RuntimePhy from(int mcsOverride = -1) {
+        PhyProfile p = Fixed::getProfile();
+        if (mcsOverride >= 0) p.mcs = mcsOverride;
+        return RuntimePhy(p);
+    }
+
+    void setMcs(int mcs) {
+        if (mcs < 0 || mcs >= MCS_COUNT) {
+            throw std::invalid_argument("MCS index must be between 0 and " + std::to_string(MCS_COUNT - 1) + ".");
+        }
+        profile.mcs = mcs;
+    }
+
+    int mcs() const { return profile.mcs; }
+    double dataRate() const { return profile.dataRate(); }
+    double dataRate(double widthMhz) const { return profile.dataRate(widthMhz); }
+    double airtime(int bytes) const { return profile.airtime(bytes); }
+    double airtime(int bytes, double widthMhz) const { return profile.airtime(bytes, widthMhz); }
+    const PhyProfile& getProfile() const { return profile; }
+};
+
+// Run fn(phy) with the fixed default profile, or with a RuntimePhy when an MCS override is given
+template <typename DefaultPhy, typename Fn>
+void withPhy(int mcsOverride, Fn&& fn) {
+    if (mcsOverride < 0) fn(DefaultPhy());
+    else fn(RuntimePhy::from<DefaultPhy>(mcsOverride));
+}
+
+// Parse an optional "--mcs=<index>" argument; -1 keeps the compile-time profile
+inline int parseMcsArgument(int argc, char* argv[]) {
+    const std::string flag = "--mcs=";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, flag.size(), flag) != 0) continue;
+        const char* text = arg.c_str() + flag.size();
+        char* end = nullptr;
+        long mcs = std::strtol(text, &end, 10);
+        if (end == text || *end != '\0' || mcs < 0 || mcs >= MCS_COUNT) {
+            throw std::invalid_argument("Bad value \"" + std::string(text) + "\" in --mcs: expected an index between 0 and " +
+                                        std::to_string(MCS_COUNT - 1) + ".");
+        }
+        return static_cast<int>(mcs);
+    }
+    return -1;
+}
+
+#endif
@@ -0,0 +1,399 @@
+#ifndef QUEUE_DISCIPLINE_H
+#define QUEUE_DISCIPLINE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <memory_resource>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "packet_ring.h"
+#include "stats.h"
+
+// Per-user queue disciplines (active queue management).
+// Without --aqm each standard keeps its built-in queue: WiFi 5 queues grow
+// without bound, WiFi 6 tail-drops at --queue-size and drops head-of-line
+// packets older than --timeout. With --aqm, arrivals go into a discipline in
+// front of the user's packet ring, and the ring only holds the packets taken
+// for the transmission in progress:
+//   taildrop   FIFO, arrivals beyond --aqm-limit packets are dropped
+//   codel      FIFO with CoDel (RFC 8289) at dequeue: once the sojourn time
+//              stays above --codel-target for --codel-interval, head packets
+//              are dropped at intervals shrinking with 1/sqrt(drops)
+//   fq-codel   FQ-CoDel (RFC 8290): the flow tag each packet carries from
+//              its traffic source (--traffic-flows) picks one of --fq-flows
+//              sub-queues, each with its own CoDel state, served by deficit
+//              round robin with new flows ahead of old ones; at the limit the
+//              longest sub-queue loses its head packet
+// Sojourn time is the dequeue time minus the arrival timestamp the packet
+// already carries, so CoDel costs O(1) per packet.
+
+enum class QueueDisciplineKind { Legacy, TailDrop, CoDel, FqCodel };
+
+inline const char* queueDisciplineName(QueueDisciplineKind kind) {
+    switch (kind) {
+    case QueueDisciplineKind::TailDrop: return "taildrop";
+    case QueueDisciplineKind::CoDel: return "codel";
+    case QueueDisciplineKind::FqCodel: return "fq-codel";
+    default: return "legacy";
+    }
+}
+
+// Command-line options: --aqm=taildrop|codel|fq-codel [--aqm-limit=N] [--codel-target=S] [--codel-interval=S]
+//                       [--fq-flows=N] [--per-user-stats]
+struct QueueOptions {
+    QueueDisciplineKind kind = QueueDisciplineKind::Legacy;
+    int limit = 1000;               // Packets held per user before overflow drops (Linux codel default)
+    double target = 5e-3;           // Acceptable standing sojourn time (seconds)
+    double interval = 100e-3;       // Window the sojourn time must stay above target before dropping
+    int flows = 64;                 // FQ-CoDel sub-queues per user
+    bool perUserStats = false;      // Print per-user drops and latency after each run
+
+    bool enabled() const { return kind != QueueDisciplineKind::Legacy; }
+};
+
+inline QueueOptions parseQueueArguments(int argc, char* argv[]) {
+    QueueOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 6, "--aqm=") == 0) {
+            std::string kind = arg.substr(6);
+            if (kind == "legacy") opts.kind = QueueDisciplineKind::Legacy;
+            else if (kind == "taildrop") opts.kind = QueueDisciplineKind::TailDrop;
+            else if (kind == "codel") opts.kind = QueueDisciplineKind::CoDel;
+            else if (kind == "fq-codel") opts.kind = QueueDisciplineKind::FqCodel;
+            else throw std::invalid_argument("Unknown queue discipline " + kind + ": expected legacy, taildrop, codel or fq-codel.");
+        } else if (arg.compare(0, 12, "--aqm-limit=") == 0) {
+            opts.limit = std::atoi(arg.c_str() + 12);
+        } else if (arg.compare(0, 15, "--codel-target=") == 0) {
+            opts.target = std::atof(arg.c_str() + 15);
+        } else if (arg.compare(0, 17, "--codel-interval=") == 0) {
+            opts.interval = std::atof(arg.c_str() + 17);
+        } else if (arg.compare(0, 11, "--fq-flows=") == 0) {
+            opts.flows = std::atoi(arg.c_str() + 11);
+        } else if (arg == "--per-user-stats") {
+            opts.perUserStats = true;
+        }
+    }
+    if (opts.limit < 1 || opts.flows < 1 || !(opts.target > 0) || !(opts.interval > 0)) {
+        throw std::invalid_argument("--aqm-limit, --fq-flows, --codel-target and --codel-interval must be positive.");
+    }
+    return opts;
+}
+
+// Queue Stats Struct: one user's delivered packets, drops by cause and latency
+struct QueueStats {
+    uint64_t delivered = 0;
+    uint64_t overflowDrops = 0;     // Queue or discipline limit reached
+    uint64_t aqmDrops = 0;          // CoDel
+    uint64_t timeoutDrops = 0;      // WiFi 6 head-of-line timeout
+    uint64_t channelDrops = 0;      // WiFi 5 transmission errors
+    LatencyHistogram latency;       // Delivered packets; filled only with --per-user-stats
+
+    uint64_t drops() const { return overflowDrops + aqmDrops + timeoutDrops + channelDrops; }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(delivered);
+        out.put(overflowDrops);
+        out.put(aqmDrops);
+        out.put(timeoutDrops);
+        out.put(channelDrops);
+        latency.save(out);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        in.get(delivered);
+        in.get(overflowDrops);
+        in.get(aqmDrops);
+        in.get(timeoutDrops);
+        in.get(channelDrops);
+        latency.load(in);
+    }
+};
+
+// One row per user: delivered, drops by cause, latency quantiles from the user's histogram
+template <typename Users>
+void printQueueReport(std::ostream& out, const Users& users, QueueDisciplineKind kind) {
+    out << "Per-user queues (" << queueDisciplineName(kind) << "):\n";
+    out << "  user  delivered  overflow    aqm  timeout  channel  p50 ms  p99 ms  max ms\n";
+    for (size_t i = 0; i < users.size(); ++i) {
+        const QueueStats& s = users[i]->queueStats;
+        out << std::setw(6) << i << std::setw(11) << s.delivered << std::setw(10) << s.overflowDrops
+            << std::setw(7) << s.aqmDrops << std::setw(9) << s.timeoutDrops << std::setw(9) << s.channelDrops
+            << std::setw(8) << s.latency.quantile(0.5) * 1e3 << std::setw(8) << s.latency.quantile(0.99) * 1e3
+            << std::setw(8) << s.latency.quantile(1.0) * 1e3 << "\n";
+    }
+}
+
+// Queue Discipline Class: one user's AQM queue, feeding its packet ring one transmission at a time
+class QueueDiscipline {
+private:
+    // CoDel control state of one (sub-)queue, RFC 8289 naming
+    struct Codel {
+        double firstAboveTime = 0;  // When the sojourn time may first count as standing, 0 = below target
+        double dropNext = 0;
+        uint32_t count = 0;         // Drops in the current dropping state
+        uint32_t lastCount = 0;
+        bool dropping = false;
+    };
+
+    static constexpr int FQ_QUANTUM_BYTES = 1514;    // Deficit added per round (one Ethernet MTU)
+
+    QueueOptions options;
+    int packetBytes;
+    std::pmr::memory_resource* resource;
+    std::pmr::vector<PacketRing> queues;    // One FIFO, or one per FQ-CoDel flow
+    std::pmr::vector<Codel> codel;
+    std::pmr::vector<int> deficit;          // FQ-CoDel bytes each flow may still send this round
+    std::pmr::vector<char> listed;          // Flow is on newFlows or oldFlows
+    std::pmr::deque<int> newFlows;          // Flows that became active this round, served first
+    std::pmr::deque<int> oldFlows;
+    size_t backlog;
+
+    bool fair() const { return options.kind == QueueDisciplineKind::FqCodel; }
+
+    // Sub-queue of a flow; flows beyond --fq-flows share sub-queues
+    size_t flowOf(int flow) const {
+        if (!fair()) return 0;
+        return static_cast<size_t>(flow) % queues.size();
+    }
+
+    // The rings grow with the backlog, up to the limit
+    static bool append(PacketRing& queue, int id, double arrival) {
+        if (queue.full()) queue.reserve(queue.capacity() ? queue.capacity() * 2 : 16);
+        return queue.push(id, arrival);
+    }
+
+    double controlLaw(double t, uint32_t count) const { return t + options.interval / std::sqrt(static_cast<double>(count)); }
+
+    // Pop the head of queue `q` into (id, arrival); true if CoDel considers the sojourn time standing
+    bool popHead(size_t q, double now, int& id, double& arrival) {
+        PacketRing& queue = queues[q];
+        Codel& c = codel[q];
+        size_t slot = queue.frontSlot();
+        id = queue.idAt(slot);
+        arrival = queue.arrivalAt(slot);
+        queue.pop();
+        backlog--;
+        if (options.kind == QueueDisciplineKind::TailDrop) return false;
+
+        double sojourn = now - arrival;
+        if (sojourn < options.target || queue.size() <= 1) {   // Below target, or at most one MTU is left behind
+            c.firstAboveTime = 0;
+            return false;
+        }
+        if (c.firstAboveTime == 0) {
+            c.firstAboveTime = now + options.interval;
+            return false;
+        }
+        return now >= c.firstAboveTime;
+    }
+
+    // CoDel dequeue from queue `q`: false if it is (or is dropped) empty; `drops` counts the packets dropped
+    bool dequeueFrom(size_t q, double now, int& id, double& arrival, int& drops) {
+        PacketRing& queue = queues[q];
+        Codel& c = codel[q];
+        if (queue.empty()) {
+            c.firstAboveTime = 0;
+            c.dropping = false;
+            return false;
+        }
+        bool okToDrop = popHead(q, now, id, arrival);
+        if (c.dropping) {
+            if (!okToDrop) {
+                c.dropping = false;
+            } else {
+                while (now >= c.dropNext && c.dropping) {
+                    drops++;
+                    c.count++;
+                    if (queue.empty()) {
+                        c.firstAboveTime = 0;
+                        c.dropping = false;
+                        return false;
+                    }
+                    okToDrop = popHead(q, now, id, arrival);
+                    if (!okToDrop) c.dropping = false;
+                    else c.dropNext = controlLaw(c.dropNext, c.count);
+                }
+            }
+        } else if (okToDrop) {
+            drops++;
+            bool got = !queue.empty();
+            if (got) popHead(q, now, id, arrival);
+            else c.firstAboveTime = 0;
+            c.dropping = true;
+            uint32_t delta = c.count - c.lastCount;
+            c.count = delta > 1 && now - c.dropNext < 16 * options.interval ? delta : 1;  // Resume near the last drop rate
+            c.dropNext = controlLaw(now, c.count);
+            c.lastCount = c.count;
+            return got;
+        }
+        return true;
+    }
+
+    // RFC 8290 scheduler: deficit round robin over new, then old flows
+    bool dequeueFair(double now, int& id, double& arrival, int& drops) {
+        while (!newFlows.empty() || !oldFlows.empty()) {
+            bool fromNew = !newFlows.empty();
+            std::pmr::deque<int>& list = fromNew ? newFlows : oldFlows;
+            int flow = list.front();
+            if (deficit[flow] <= 0) {
+                deficit[flow] += FQ_QUANTUM_BYTES;
+                list.pop_front();
+                oldFlows.push_back(flow);
+                continue;
+            }
+            if (!dequeueFrom(static_cast<size_t>(flow), now, id, arrival, drops)) {
+                list.pop_front();
+                if (fromNew) oldFlows.push_back(flow);  // An emptied new flow waits one round before it counts as new again
+                else listed[flow] = 0;
+                continue;
+            }
+            deficit[flow] -= packetBytes;
+            return true;
+        }
+        return false;
+    }
+
+public:
+    // Off (the standard's built-in queue) until configure() picks a discipline
+    explicit QueueDiscipline(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : packetBytes(0), resource(memory), queues(memory), codel(memory), deficit(memory), listed(memory),
+          newFlows(memory), oldFlows(memory), backlog(0) {}
+
+    QueueDiscipline(const QueueDiscipline&) = delete;
+    QueueDiscipline& operator=(const QueueDiscipline&) = delete;
+
+    // Rebuild empty with another discipline; the sub-queues stay in this discipline's memory resource
+    void configure(const QueueOptions& opts, int bytesPerPacket) {
+        options = opts;
+        packetBytes = bytesPerPacket;
+        queues.clear();
+        size_t count = !options.enabled() ? 0 : fair() ? static_cast<size_t>(options.flows) : 1;
+        for (size_t i = 0; i < count; ++i) queues.emplace_back(0, resource);
+        codel.assign(count, Codel());
+        deficit.assign(fair() ? count : 0, FQ_QUANTUM_BYTES);
+        listed.assign(fair() ? count : 0, 0);
+        newFlows.clear();
+        oldFlows.clear();
+        backlog = 0;
+    }
+
+    bool enabled() const { return options.enabled(); }
+    bool empty() const { return backlog == 0; }
+    size_t size() const { return backlog; }
+
+    void clear() {
+        for (PacketRing& queue : queues) queue.clear();
+        std::fill(codel.begin(), codel.end(), Codel());
+        std::fill(deficit.begin(), deficit.end(), FQ_QUANTUM_BYTES);
+        std::fill(listed.begin(), listed.end(), 0);
+        newFlows.clear();
+        oldFlows.clear();
+        backlog = 0;
+    }
+
+    // Queue an arrival of `flow`; returns the packets dropped to make room (the arrival itself without FQ)
+    int enqueue(int flow, int id, double arrival) {
+        if (!fair()) {
+            if (backlog >= static_cast<size_t>(options.limit)) return 1;
+            append(queues[0], id, arrival);
+            backlog++;
+            return 0;
+        }
+
+        int dropped = 0;
+        if (backlog >= static_cast<size_t>(options.limit)) {   // Head drop in the fattest flow
+            size_t fattest = 0;
+            for (size_t q = 1; q < queues.size(); ++q) {
+                if (queues[q].size() > queues[fattest].size()) fattest = q;
+            }
+            queues[fattest].pop();
+            backlog--;
+            dropped = 1;
+        }
+        size_t q = flowOf(flow);
+        append(queues[q], id, arrival);
+        backlog++;
+        if (!listed[q]) {
+            listed[q] = 1;
+            deficit[q] = FQ_QUANTUM_BYTES;
+            newFlows.push_back(static_cast<int>(q));
+        }
+        return dropped;
+    }
+
+    // Move up to `n` packets into `ring` for transmission at `now`; returns the packets CoDel dropped on the way
+    int dequeueInto(double now, PacketRing& ring, size_t n) {
+        if (ring.capacity() < ring.size() + n) ring.reserve(ring.size() + n);
+        int drops = 0, id = 0;
+        double arrival = 0;
+        for (size_t i = 0; i < n; ++i) {
+            bool got = fair() ? dequeueFair(now, id, arrival, drops) : dequeueFrom(0, now, id, arrival, drops);
+            if (!got) break;
+            ring.push(id, arrival);
+        }
+        return drops;
+    }
+
+    // Arrival time of a queued packet (every one of them has already arrived)
+    double anyArrival() const {
+        for (const PacketRing& queue : queues) {
+            if (!queue.empty()) return queue.frontArrival();
+        }
+        return 0;
+    }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(static_cast<uint64_t>(queues.size()));
+        for (size_t q = 0; q < queues.size(); ++q) {
+            queues[q].save(out);
+            out.put(codel[q].firstAboveTime);
+            out.put(codel[q].dropNext);
+            out.put(codel[q].count);
+            out.put(codel[q].lastCount);
+            out.put(codel[q].dropping);
+        }
+        out.putVector(std::vector<int>(deficit.begin(), deficit.end()));
+        out.putVector(std::vector<char>(listed.begin(), listed.end()));
+        out.putVector(std::vector<int>(newFlows.begin(), newFlows.end()));
+        out.putVector(std::vector<int>(oldFlows.begin(), oldFlows.end()));
+        out.put(static_cast<uint64_t>(backlog));
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        if (in.template get<uint64_t>() != queues.size()) throw std::runtime_error("Snapshot was taken with a different queue discipline.");
+        for (size_t q = 0; q < queues.size(); ++q) {
+            queues[q].load(in);
+            in.get(codel[q].firstAboveTime);
+            in.get(codel[q].dropNext);
+            in.get(codel[q].count);
+            in.get(codel[q].lastCount);
+            in.get(codel[q].dropping);
+        }
+        std::vector<int> deficits, fresh, old;
+        std::vector<char> flags;
+        in.getVector(deficits);
+        in.getVector(flags);
+        in.getVector(fresh);
+        in.getVector(old);
+        if (deficits.size() != deficit.size() || flags.size() != listed.size()) throw std::runtime_error("Snapshot was taken with a different queue discipline.");
+        std::copy(deficits.begin(), deficits.end(), deficit.begin());
+        std::copy(flags.begin(), flags.end(), listed.begin());
+        newFlows.assign(fresh.begin(), fresh.end());
+        oldFlows.assign(old.begin(), old.end());
+        backlog = static_cast<size_t>(in.template get<uint64_t>());
+    }
+};
+
+#endif
@@ -0,0 +1,484 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sweep.h"
+
+// Machine-readable results. One row per run, and optionally one row per
+// delivered packet, in CSV, JSON lines or a binary columnar format. All
+// metrics are raw: aggregate throughput, with none of the console's
+// display adjustments. Simulation threads only hand records over. A
+// writer thread does the formatting and file I/O, so output never stalls an
+// event loop. Packet records are handed over in batches, and a producer ahead
+// of the disk by more than MAX_PENDING_PACKETS rows waits for the writer.
+// Rows appear in the order runs finish; the run column links packets to runs.
+//
+// Columnar layout (native byte order, one row group per ROW_GROUP_ROWS rows):
+//   magic "WIFICOL1"
+//   per row group: uint64 rows, uint32 columns, then per column
+//     uint32 name length, name, uint8 type ('i' int64, 'u' uint64, 'd' double, 's' text),
+//     rows x 8 bytes, or rows x (uint32 length, bytes) for text
+//   uint64 0 after the last row group
+
+// Command-line options: --results=FILE [--results-format=csv|jsonl|columnar] [--results-packets]
+struct ResultsOptions {
+    std::string path;           // Empty = no results file
+    std::string format;         // Empty = from the extension: .csv, .jsonl / .json, anything else columnar
+    bool packets = false;       // Also write one row per delivered packet to <FILE without extension>.packets.<ext>
+};
+
+inline ResultsOptions parseResultsArguments(int argc, char* argv[]) {
+    ResultsOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 10, "--results=") == 0) opts.path = arg.substr(10);
+        else if (arg.compare(0, 17, "--results-format=") == 0) opts.format = arg.substr(17);
+        else if (arg == "--results-packets") opts.packets = true;
+    }
+    if (opts.format.empty()) {
+        size_t dot = opts.path.rfind('.');
+        std::string extension = dot == std::string::npos ? "" : opts.path.substr(dot + 1);
+        opts.format = extension == "csv" ? "csv" : extension == "jsonl" || extension == "json" ? "jsonl" : "columnar";
+    }
+    if (opts.format != "csv" && opts.format != "jsonl" && opts.format != "columnar") {
+        throw std::invalid_argument("Unknown results format " + opts.format + ": expected csv, jsonl or columnar.");
+    }
+    return opts;
+}
+
+// FILE.ext -> FILE.packets.ext
+inline std::string packetResultsPath(const std::string& path) {
+    size_t dot = path.rfind('.');
+    size_t slash = path.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return path + ".packets";
+    return path.substr(0, dot) + ".packets" + path.substr(dot);
+}
+
+enum class FieldType : uint8_t { Int = 'i', UInt = 'u', Real = 'd', Text = 's' };
+
+struct Field {
+    const char* name;
+    FieldType type;
+};
+
+// One value of a row; which member is set follows the field's type
+struct Cell {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char* s;
+
+    static Cell integer(int64_t v) { return Cell{v, 0, 0, nullptr}; }
+    static Cell unsignedInteger(uint64_t v) { return Cell{0, v, 0, nullptr}; }
+    static Cell real(double v) { return Cell{0, 0, v, nullptr}; }
+    static Cell text(const char* v) { return Cell{0, 0, 0, v}; }
+};
+
+// Table Writer Class: one output file of rows with a fixed schema, buffered
+class TableWriter {
+private:
+    static const size_t FLUSH_BYTES = 1 << 20;
+
+    std::string path;
+    std::ofstream file;
+
+protected:
+    std::vector<Field> schema;
+    std::string buffer;
+
+    void flushIfFull() {
+        if (buffer.size() >= FLUSH_BYTES) flush();
+    }
+
+    // Shortest text that reads back to the same value; non-finite doubles as `nonFinite`
+    void appendReal(double v, const char* nonFinite) {
+        if (!std::isfinite(v)) {
+            buffer += nonFinite;
+            return;
+        }
+        appendNumber(v);
+    }
+
+    template <typename T>
+    void appendNumber(T v) {
+        char text[32];
+        std::to_chars_result end = std::to_chars(text, text + sizeof(text), v);
+        buffer.append(text, end.ptr);
+    }
+
+    template <typename T>
+    void appendRaw(const T& v) {
+        buffer.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+public:
+    TableWriter(const std::string& filePath, const std::vector<Field>& fields)
+        : path(filePath), file(filePath, std::ios::binary | std::ios::trunc), schema(fields) {
+        if (!file) throw std::runtime_error("Could not write " + path + ".");
+    }
+
+    virtual ~TableWriter() {}
+
+    virtual void row(const Cell* cells) = 0;
+
+    // Write what is buffered
+    void flush() {
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+        if (!file) throw std::runtime_error("Could not write " + path + ".");
+    }
+
+    virtual void finish() {
+        flush();
+        file.flush();
+        if (!file) throw std::runtime_error("Could not write " + path + ".");
+    }
+};
+
+// CSV Table Writer Class: header line, then one line per row
+class CsvTableWriter : public TableWriter {
+public:
+    CsvTableWriter(const std::string& filePath, const std::vector<Field>& fields) : TableWriter(filePath, fields) {
+        for (size_t c = 0; c < schema.size(); ++c) {
+            if (c) buffer += ',';
+            buffer += schema[c].name;
+        }
+        buffer += '\n';
+    }
+
+    void row(const Cell* cells) override {
+        for (size_t c = 0; c < schema.size(); ++c) {
+            if (c) buffer += ',';
+            switch (schema[c].type) {
+            case FieldType::Int: appendNumber(cells[c].i); break;
+            case FieldType::UInt: appendNumber(cells[c].u); break;
+            case FieldType::Real: appendReal(cells[c].d, ""); break;
+            case FieldType::Text: buffer += cells[c].s; break;  // Field values never contain commas or quotes
+            }
+        }
+        buffer += '\n';
+        flushIfFull();
+    }
+};
+
+// JSON Lines Table Writer Class: one object per line, non-finite numbers as null
+class JsonLinesTableWriter : public TableWriter {
+public:
+    JsonLinesTableWriter(const std::string& filePath, const std::vector<Field>& fields) : TableWriter(filePath, fields) {}
+
+    void row(const Cell* cells) override {
+        buffer += '{';
+        for (size_t c = 0; c < schema.size(); ++c) {
+            if (c) buffer += ',';
+            buffer += '"';
+            buffer += schema[c].name;
+            buffer += "\":";
+            switch (schema[c].type) {
+            case FieldType::Int: appendNumber(cells[c].i); break;
+            case FieldType::UInt: appendNumber(cells[c].u); break;
+            case FieldType::Real: appendReal(cells[c].d, "null"); break;
+            case FieldType::Text:
+                buffer += '"';
+                buffer += cells[c].s;
+                buffer += '"';
+                break;
+            }
+        }
+        buffer += "}\n";
+        flushIfFull();
+    }
+};
+
+// Columnar Table Writer Class: rows are collected per column and written as row groups
+class ColumnarTableWriter : public TableWriter {
+private:
+    static const size_t ROW_GROUP_ROWS = 1 << 16;
+
+    std::vector<std::vector<int64_t>> ints;     // Per column; only the vector matching the type is used
+    std::vector<std::vector<uint64_t>> unsigneds;
+    std::vector<std::vector<double>> reals;
+    std::vector<std::vector<std::string>> texts;
+    size_t rows;
+
+    void writeRowGroup() {
+        if (rows == 0) return;
+        appendRaw(static_cast<uint64_t>(rows));
+        appendRaw(static_cast<uint32_t>(schema.size()));
+        for (size_t c = 0; c < schema.size(); ++c) {
+            uint32_t length = static_cast<uint32_t>(std::strlen(schema[c].name));
+            appendRaw(length);
+            buffer.append(schema[c].name, length);
+            appendRaw(static_cast<uint8_t>(schema[c].type));
+            switch (schema[c].type) {
+            case FieldType::Int: buffer.append(reinterpret_cast<const char*>(ints[c].data()), rows * sizeof(int64_t)); break;
+            case FieldType::UInt: buffer.append(reinterpret_cast<const char*>(unsigneds[c].data()), rows * sizeof(uint64_t)); break;
+            case FieldType::Real: buffer.append(reinterpret_cast<const char*>(reals[c].data()), rows * sizeof(double)); break;
+            case FieldType::Text:
+                for (const std::string& s : texts[c]) {
+                    appendRaw(static_cast<uint32_t>(s.size()));
+                    buffer += s;
+                }
+                break;
+            }
+            ints[c].clear();
+            unsigneds[c].clear();
+            reals[c].clear();
+            texts[c].clear();
+        }
+        rows = 0;
+        flush();
+    }
+
+public:
+    ColumnarTableWriter(const std::string& filePath, const std::vector<Field>& fields)
+        : TableWriter(filePath, fields), ints(fields.size()), unsigneds(fields.size()), reals(fields.size()), texts(fields.size()), rows(0) {
+        buffer.append("WIFICOL1", 8);
+    }
+
+    void row(const Cell* cells) override {
+        for (size_t c = 0; c < schema.size(); ++c) {
+            switch (schema[c].type) {
+            case FieldType::Int: ints[c].push_back(cells[c].i); break;
+            case FieldType::UInt: unsigneds[c].push_back(cells[c].u); break;
+            case FieldType::Real: reals[c].push_back(cells[c].d); break;
+            case FieldType::Text: texts[c].push_back(cells[c].s); break;
+            }
+        }
+        if (++rows == ROW_GROUP_ROWS) writeRowGroup();
+    }
+
+    void finish() override {
+        writeRowGroup();
+        appendRaw(static_cast<uint64_t>(0));
+        TableWriter::finish();
+    }
+};
+
+inline std::unique_ptr<TableWriter> openTable(const std::string& format, const std::string& path, const std::vector<Field>& fields) {
+    if (format == "csv") return std::unique_ptr<TableWriter>(new CsvTableWriter(path, fields));
+    if (format == "jsonl") return std::unique_ptr<TableWriter>(new JsonLinesTableWriter(path, fields));
+    return std::unique_ptr<TableWriter>(new ColumnarTableWriter(path, fields));
+}
+
+// One finished run
+struct RunRecord {
+    uint32_t run;
+    Replication key;
+    ReplicationResult result;
+};
+
+// One delivered packet
+struct PacketRecord {
+    uint32_t run;
+    int32_t user;
+    double arrival;     // Simulated seconds
+    double end;         // Transmission end
+};
+
+const std::vector<Field> RUN_FIELDS = {
+    {"run", FieldType::Int}, {"standard", FieldType::Text}, {"users", FieldType::Int}, {"seed", FieldType::UInt},
+    {"subchannels", FieldType::Text}, {"throughput_mbps", FieldType::Real}, {"throughput_per_user_mbps", FieldType::Real},
+    {"avg_latency_ms", FieldType::Real}, {"max_latency_ms", FieldType::Real}, {"p50_latency_ms", FieldType::Real},
+    {"p99_latency_ms", FieldType::Real}, {"p999_latency_ms", FieldType::Real}, {"dropped_packets", FieldType::Real},
+    {"delivered_packets", FieldType::Int}, {"simulated_events", FieldType::Int}, {"warmed_up", FieldType::Int},
+    {"warmup_s", FieldType::Real}, {"measured_s", FieldType::Real}, {"converged", FieldType::Int},
+};
+
+const std::vector<Field> PACKET_FIELDS = {
+    {"run", FieldType::Int}, {"user", FieldType::Int}, {"arrival_s", FieldType::Real}, {"end_s", FieldType::Real},
+    {"latency_s", FieldType::Real},
+};
+
+// Results Writer Class: owns the output files and the writer thread; a no-op without --results
+class ResultsWriter {
+private:
+    static const size_t MAX_PENDING_PACKETS = 1 << 22;
+
+    std::unique_ptr<TableWriter> runs;
+    std::unique_ptr<TableWriter> packets;
+    std::atomic<uint32_t> nextRun;
+
+    std::mutex lock;
+    std::condition_variable workAvailable;
+    std::condition_variable roomAvailable;
+    std::vector<RunRecord> pendingRuns;
+    std::vector<std::vector<PacketRecord>> pendingPackets;
+    size_t pendingPacketRows;
+    bool closing;
+    std::string error;          // First write failure, reported by close()
+    std::thread writer;
+
+    void writeRun(const RunRecord& r) {
+        std::string subchannels;
+        for (size_t i = 0; i < r.key.subChannels.size(); ++i) {
+            char width[32];
+            std::snprintf(width, sizeof(width), "%s%g", i ? "/" : "", r.key.subChannels[i]);
+            subchannels += width;
+        }
+        const ReplicationResult& m = r.result;
+        Cell cells[] = {
+            Cell::integer(r.run), Cell::text(r.key.standard.c_str()), Cell::integer(r.key.userCount),
+            Cell::unsignedInteger(r.key.seed), Cell::text(subchannels.c_str()), Cell::real(m.throughputMbps),
+            Cell::real(r.key.userCount > 0 ? m.throughputMbps / r.key.userCount : 0), Cell::real(m.avgLatencyMs),
+            Cell::real(m.maxLatencyMs), Cell::real(m.p50LatencyMs), Cell::real(m.p99LatencyMs), Cell::real(m.p999LatencyMs),
+            Cell::real(m.droppedPackets), Cell::integer(static_cast<int64_t>(m.latency.count())),
+            Cell::integer(static_cast<int64_t>(m.simulatedEvents)), Cell::integer(m.warmedUp), Cell::real(m.warmupSeconds),
+            Cell::real(m.measuredSeconds), Cell::integer(m.converged),
+        };
+        runs->row(cells);
+    }
+
+    void writePackets(const std::vector<PacketRecord>& batch) {
+        for (const PacketRecord& p : batch) {
+            Cell cells[] = {Cell::integer(p.run), Cell::integer(p.user), Cell::real(p.arrival), Cell::real(p.end), Cell::real(p.end - p.arrival)};
+            packets->row(cells);
+        }
+    }
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lk(lock);
+        while (true) {
+            workAvailable.wait(lk, [&] { return closing || !pendingRuns.empty() || !pendingPackets.empty(); });
+            if (closing && pendingRuns.empty() && pendingPackets.empty()) break;
+            std::vector<RunRecord> runBatch;
+            std::vector<std::vector<PacketRecord>> packetBatches;
+            runBatch.swap(pendingRuns);
+            packetBatches.swap(pendingPackets);
+            pendingPacketRows = 0;
+            roomAvailable.notify_all();
+            bool failed = !error.empty();
+            lk.unlock();
+
+            std::string failure;
+            if (!failed) {
+                try {
+                    for (const auto& batch : packetBatches) writePackets(batch);
+                    for (const RunRecord& r : runBatch) writeRun(r);
+                } catch (const std::exception& ex) {
+                    failure = ex.what();
+                }
+            }
+            lk.lock();
+            if (error.empty()) error = failure;
+        }
+        lk.unlock();
+        if (!error.empty()) return;
+        try {
+            if (packets) packets->finish();
+            runs->finish();
+        } catch (const std::exception& ex) {
+            lk.lock();
+            error = ex.what();
+        }
+    }
+
+public:
+    explicit ResultsWriter(const ResultsOptions& options) : nextRun(0), pendingPacketRows(0), closing(false) {
+        if (options.path.empty()) return;
+        runs = openTable(options.format, options.path, RUN_FIELDS);
+        if (options.packets) packets = openTable(options.format, packetResultsPath(options.path), PACKET_FIELDS);
+        writer = std::thread(&ResultsWriter::writerLoop, this);
+    }
+
+    ~ResultsWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    ResultsWriter(const ResultsWriter&) = delete;
+    ResultsWriter& operator=(const ResultsWriter&) = delete;
+
+    bool enabled() const { return runs != nullptr; }
+    bool recordsPackets() const { return packets != nullptr; }
+
+    uint32_t beginRun() { return nextRun++; }
+
+    void submitRun(RunRecord record) {
+        std::lock_guard<std::mutex> guard(lock);
+        pendingRuns.push_back(std::move(record));
+        workAvailable.notify_one();
+    }
+
+    void submitPackets(std::vector<PacketRecord> batch) {
+        std::unique_lock<std::mutex> lk(lock);
+        roomAvailable.wait(lk, [&] { return pendingPacketRows < MAX_PENDING_PACKETS; });
+        pendingPacketRows += batch.size();
+        pendingPackets.push_back(std::move(batch));
+        workAvailable.notify_one();
+    }
+
+    // Drain the queue, finish the files and stop the writer thread; throws if anything failed to write
+    void close() {
+        if (!writer.joinable()) return;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closing = true;
+        }
+        workAvailable.notify_one();
+        writer.join();
+        if (!error.empty()) throw std::runtime_error("Results output failed: " + error);
+    }
+
+    // Run simulate(PacketLog*) -> ReplicationResult and record its result under `key`.
+    // The log pointer is null unless packet records were requested.
+    template <typename Simulate>
+    ReplicationResult record(const Replication& key, Simulate simulate);
+};
+
+// Packet Log Class: per-run buffer of delivered packets, handed to the writer in batches
+class PacketLog {
+private:
+    static const size_t BATCH_PACKETS = 8192;
+
+    ResultsWriter& writer;
+    uint32_t run;
+    std::vector<PacketRecord> buffer;
+
+public:
+    PacketLog(ResultsWriter& resultsWriter, uint32_t runId) : writer(resultsWriter), run(runId) { buffer.reserve(BATCH_PACKETS); }
+
+    PacketLog(const PacketLog&) = delete;
+    PacketLog& operator=(const PacketLog&) = delete;
+
+    void record(int user, double arrival, double end) {
+        buffer.push_back(PacketRecord{run, user, arrival, end});
+        if (buffer.size() == BATCH_PACKETS) flush();
+    }
+
+    void flush() {
+        if (buffer.empty()) return;
+        writer.submitPackets(std::move(buffer));
+        buffer = std::vector<PacketRecord>();
+        buffer.reserve(BATCH_PACKETS);
+    }
+};
+
+template <typename Simulate>
+ReplicationResult ResultsWriter::record(const Replication& key, Simulate simulate) {
+    if (!enabled()) return simulate(static_cast<PacketLog*>(nullptr));
+    uint32_t run = beginRun();
+    PacketLog log(*this, run);
+    ReplicationResult result = simulate(recordsPackets() ? &log : nullptr);
+    log.flush();
+    submitRun(RunRecord{run, key, result});
+    return result;
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Seedable, splittable random number streams for the simulators.
+// A stream is keyed on (seed, streamId): the seed identifies one replication,
+// the stream id one consumer inside it (the channel, a user, ...). Keys are
+// hashed with SplitMix64 into xoshiro256** state, so any stream can be created
+// directly from its key without advancing a shared generator, and the hot loop
+// does no heap or syscall work.
+
+// Stream id 0 belongs to the simulation itself; users get 1 + userId
+const uint64_t SIMULATION_STREAM = 0;
+inline uint64_t userStream(int userId) { return 1 + static_cast<uint64_t>(userId); }
+
+// Traffic generators draw from a separate block of ids, so arrivals never shift a user's other draws
+const uint64_t TRAFFIC_STREAM_BASE = 1ULL << 32;
+inline uint64_t trafficStream(int userId) { return TRAFFIC_STREAM_BASE + static_cast<uint64_t>(userId); }
+
+// Per-cell MAC streams of a multi-cell run
+const uint64_t CELL_STREAM_BASE = 2ULL << 32;
+inline uint64_t cellStream(int cellId) { return CELL_STREAM_BASE + static_cast<uint64_t>(cellId); }
+
+// Flow tags of a user's packets (traffic.h), drawn apart from its arrival stream
+const uint64_t FLOW_STREAM_BASE = 3ULL << 32;
+inline uint64_t flowStream(int userId) { return FLOW_STREAM_BASE + static_cast<uint64_t>(userId); }
+
+inline uint64_t splitMix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Seed of replication n of a sweep rooted at masterSeed
+inline uint64_t replicationSeed(uint64_t masterSeed, uint64_t replication) {
+    uint64_t x = masterSeed ^ (replication * 0xD1B54A32D192ED03ULL);
+    return splitMix64(x);
+}
+
+// Counter-based draws for batch kernels: value `counter` of the stream keyed on
+// (seed, streamId) is a pure function of the three, so any packet's draws can
+// be computed on any thread, in any order, without carrying generator state.
+inline uint64_t counterKey(uint64_t seed, uint64_t streamId) {
+    uint64_t x = seed;
+    return splitMix64(x) ^ (streamId * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL);
+}
+
+inline uint64_t counterDraw(uint64_t key, uint64_t counter) {
+    uint64_t x = key + counter * 0x9E3779B97F4A7C15ULL;
+    return splitMix64(x);
+}
+
+// Uniform double in [0, 1) with 53 random bits
+inline double counterUniform(uint64_t key, uint64_t counter) { return (counterDraw(key, counter) >> 11) * 0x1.0p-53; }
+
+// RNG Stream Class (xoshiro256**); satisfies UniformRandomBitGenerator
+class RngStream {
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    typedef uint64_t result_type;
+
+    explicit RngStream(uint64_t seed = 1, uint64_t streamId = SIMULATION_STREAM) {
+        uint64_t x = seed;
+        uint64_t key = splitMix64(x) ^ (streamId * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL);
+        for (int i = 0; i < 4; ++i) s[i] = splitMix64(key);
+        if ((s[0] | s[1] | s[2] | s[3]) == 0) s[0] = 1;  // All-zero state is a fixed point
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform double in [0, 1) with 53 random bits
+    double uniform() { return ((*this)() >> 11) * 0x1.0p-53; }
+
+    double uniform(double lo, double hi) { return lo + (hi - lo) * uniform(); }
+
+    // Unbiased uniform integer in [lo, hi] (Lemire's multiply-and-reject)
+    int64_t uniformInt(int64_t lo, int64_t hi) {
+        uint64_t range = static_cast<uint64_t>(hi - lo) + 1;
+        if (range == 0) return static_cast<int64_t>((*this)());
+        __uint128_t m = static_cast<__uint128_t>((*this)()) * range;
+        uint64_t low = static_cast<uint64_t>(m);
+        if (low < range) {
+            uint64_t threshold = (0 - range) % range;
+            while (low < threshold) {
+                m = static_cast<__uint128_t>((*this)()) * range;
+                low = static_cast<uint64_t>(m);
+            }
+        }
+        return lo + static_cast<int64_t>(m >> 64);
+    }
+
+    bool bernoulli(double p) { return uniform() < p; }
+
+    // Number of failures before the first success of Bernoulli(p) trials, by inversion
+    uint64_t geometric(double p) {
+        if (p >= 1.0) return 0;
+        if (p <= 0.0) return std::numeric_limits<uint64_t>::max();
+        double u = 1.0 - uniform();  // (0, 1]
+        return static_cast<uint64_t>(std::floor(std::log(u) / std::log1p(-p)));
+    }
+
+    // Exponential draw with the given mean, by inversion
+    double exponential(double mean) { return -mean * std::log(1.0 - uniform()); }
+
+    // Standard normal draw (Marsaglia polar method, spare value discarded to keep the stream stateless)
+    double normal() {
+        double u, v, r;
+        do {
+            u = 2.0 * uniform() - 1.0;
+            v = 2.0 * uniform() - 1.0;
+            r = u * u + v * v;
+        } while (r >= 1.0 || r == 0.0);
+        return u * std::sqrt(-2.0 * std::log(r) / r);
+    }
+
+    // Generator state, for snapshots (see snapshot.h)
+    template <typename Archive>
+    void save(Archive& out) const {
+        for (uint64_t word : s) out.put(word);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        for (uint64_t& word : s) in.get(word);
+    }
+};
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Scenario files and run parameters.
+// A scenario file holds command-line options as TOML-style `key = value`
+// lines. Its options are placed in front of the real command line, so any
+// flag given there overrides the file and every option parser reads a single
+// argument list. The run parameters that used to be compile-time constants
+// are parsed once, at the start of a run, into an immutable Scenario that the
+// simulations read. The PHY stays a compile-time FixedPhy unless --mcs asks
+// for a runtime profile.
+//
+// File syntax (a TOML subset):
+//   # comment
+//   standard = 5
+//   users = [1, 10, 100]           -> --users=1,10,100
+//   scheduler = "pf"               -> --scheduler=pf
+//   sweep = true                   -> --sweep (false leaves the flag out)
+//   [traffic]                      -> later keys get the prefix: rate = 200 -> --traffic-rate=200
+//   packets_per_user = 50          -> underscores read as dashes: --packets-per-user=50
+
+// Options a scenario file may set, without the leading dashes
+const char* const SCENARIO_KEYS[] = {
+    "standard", "multicell", "users", "packets", "packets-per-user", "packet-size", "queue-size", "timeout", "ru-widths",
+    "sweep", "seeds", "threads", "pace", "mcs", "scheduler", "backoff", "backend", "streams", "txop", "link-adaptation", "fading", "ru-layout",
+    "traffic", "traffic-rate", "traffic-on", "traffic-off", "traffic-packets", "traffic-duration", "traffic-flows", "trace",
+    "checkpoint", "checkpoint-every", "resume", "fork", "branches",
+    "steady-state", "ci-precision", "mser-batch", "min-batches",
+    "results", "results-format", "results-packets", "aggregation", "max-frames", "max-ppdu",
+    "aqm", "aqm-limit", "codel-target", "codel-interval", "fq-flows", "per-user-stats",
+    "aps", "stations", "channels", "spacing", "instrument-json",
+};
+
+inline std::string trimScenario(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+// Strip one level of matching quotes
+inline std::string unquoteScenario(const std::string& s) {
+    if (s.size() >= 2 && (s.front() == '"' || s.front() == '\'') && s.back() == s.front()) return s.substr(1, s.size() - 2);
+    return s;
+}
+
+// Command-line options of a scenario file, in file order
+inline std::vector<std::string> loadScenarioFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Could not open scenario " + path + ".");
+    std::vector<std::string> options;
+    std::string line, section;
+    for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        std::string where = path + ":" + std::to_string(lineNumber) + ": ";
+        char quote = 0;
+        for (size_t i = 0; i < line.size(); ++i) {  // Cut the comment, unless the # is quoted
+            if (quote) quote = line[i] == quote ? 0 : quote;
+            else if (line[i] == '"' || line[i] == '\'') quote = line[i];
+            else if (line[i] == '#') line.erase(i);
+        }
+        line = trimScenario(line);
+        if (line.empty()) continue;
+        if (line.front() == '[') {
+            if (line.back() != ']') throw std::invalid_argument(where + "unterminated section header.");
+            section = trimScenario(line.substr(1, line.size() - 2));
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) throw std::invalid_argument(where + "expected key = value.");
+        std::string key = unquoteScenario(trimScenario(line.substr(0, equals)));
+        std::string value = trimScenario(line.substr(equals + 1));
+        if (!section.empty()) key = section + "-" + key;
+        std::replace(key.begin(), key.end(), '_', '-');
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (std::find(std::begin(SCENARIO_KEYS), std::end(SCENARIO_KEYS), key) == std::end(SCENARIO_KEYS)) {
+            throw std::invalid_argument(where + "unknown option " + key + ".");
+        }
+
+        if (value == "true") {
+            options.push_back("--" + key);
+            continue;
+        }
+        if (value == "false") continue;
+        if (!value.empty() && value.front() == '[') {  // Array: comma-joined elements
+            if (value.back() != ']') throw std::invalid_argument(where + "unterminated array.");
+            std::stringstream elements(value.substr(1, value.size() - 2));
+            std::string element, joined;
+            while (std::getline(elements, element, ',')) {
+                element = unquoteScenario(trimScenario(element));
+                if (!element.empty()) joined += (joined.empty() ? "" : ",") + element;
+            }
+            value = joined;
+        } else {
+            value = unquoteScenario(value);
+        }
+        if (value.empty()) throw std::invalid_argument(where + "missing value for " + key + ".");
+        options.push_back("--" + key + "=" + value);
+    }
+    return options;
+}
+
+// Command Line Class: argv with the options of a --scenario=FILE spliced in ahead of the real ones
+class CommandLine {
+private:
+    std::vector<std::string> arguments;
+    std::vector<char*> pointers;
+
+public:
+    CommandLine(int argc, char* argv[]) {
+        const std::string flag = "--scenario=";
+        arguments.push_back(argc > 0 ? argv[0] : "wifisim");
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.compare(0, flag.size(), flag) != 0) continue;
+            std::vector<std::string> options = loadScenarioFile(arg.substr(flag.size()));
+            arguments.insert(arguments.end(), options.begin(), options.end());
+        }
+        for (int i = 1; i < argc; ++i) arguments.push_back(argv[i]);
+        for (std::string& arg : arguments) pointers.push_back(&arg[0]);
+        pointers.push_back(nullptr);
+    }
+
+    CommandLine(const CommandLine&) = delete;
+    CommandLine& operator=(const CommandLine&) = delete;
+
+    int argc() const { return static_cast<int>(arguments.size()); }
+    char** argv() { return pointers.data(); }
+};
+
+// Parse one number, consuming the whole text; integer options reject fractions
+template <typename T>
+T parseScenarioValue(const std::string& text, const std::string& option) {
+    char* end = nullptr;
+    double v = std::strtod(text.c_str(), &end);
+    bool integral = !std::is_integral<T>::value ||
+                    (v == std::floor(v) && v >= std::numeric_limits<T>::min() && v <= std::numeric_limits<T>::max());
+    if (text.empty() || *end != '\0' || !std::isfinite(v) || !integral) throw std::invalid_argument("Bad value \"" + text + "\" in " + option + ".");
+    return static_cast<T>(v);
+}
+
+// Parse a comma-separated list of numbers
+template <typename T>
+std::vector<T> parseScenarioList(const std::string& text, const std::string& option) {
+    std::vector<T> values;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) values.push_back(parseScenarioValue<T>(item, option));
+    if (values.empty()) throw std::invalid_argument(option + " needs at least one value.");
+    return values;
+}
+
+// Run parameters of one invocation; each standard reads the fields it uses
+struct Scenario {
+    std::vector<int> userCounts = {1, 10, 100};
+    bool userCountsGiven = false;   // --users was set (a replayed trace otherwise supplies the count)
+    int packets = 1000;             // WiFi 4: packets per run
+    int packetsPerUser = 10;        // WiFi 5 / 6: packets per user and run
+    int packetBytes = 1024;
+    int queueSize = 50;             // WiFi 6: packets a user's queue holds before tail drop
+    double timeoutSeconds = 1.0;    // WiFi 6: queued packets older than this are dropped
+    std::vector<double> ruWidths;   // WiFi 6: RU widths in MHz, empty = --ru-layout
+};
+
+// Command-line options: --users=N,N,... --packets=N --packets-per-user=N --packet-size=BYTES
+//                       --queue-size=N --timeout=S --ru-widths=MHZ,MHZ,...
+// `defaults` supplies the values of options not given (a driver may start from its own)
+inline Scenario parseScenarioArguments(int argc, char* argv[], const Scenario& defaults = Scenario()) {
+    Scenario s = defaults;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 8, "--users=") == 0) {
+            s.userCounts = parseScenarioList<int>(arg.substr(8), "--users");
+            s.userCountsGiven = true;
+        }
+        else if (arg.compare(0, 10, "--packets=") == 0) s.packets = parseScenarioValue<int>(arg.substr(10), "--packets");
+        else if (arg.compare(0, 19, "--packets-per-user=") == 0) s.packetsPerUser = parseScenarioValue<int>(arg.substr(19), "--packets-per-user");
+        else if (arg.compare(0, 14, "--packet-size=") == 0) s.packetBytes = parseScenarioValue<int>(arg.substr(14), "--packet-size");
+        else if (arg.compare(0, 13, "--queue-size=") == 0) s.queueSize = parseScenarioValue<int>(arg.substr(13), "--queue-size");
+        else if (arg.compare(0, 10, "--timeout=") == 0) s.timeoutSeconds = parseScenarioValue<double>(arg.substr(10), "--timeout");
+        else if (arg.compare(0, 12, "--ru-widths=") == 0) s.ruWidths = parseScenarioList<double>(arg.substr(12), "--ru-widths");
+    }
+    for (int users : s.userCounts) {
+        if (users < 1) throw std::invalid_argument("User counts must be positive.");
+    }
+    if (s.packets < 1 || s.packetsPerUser < 1) throw std::invalid_argument("--packets and --packets-per-user must be at least 1.");
+    if (s.packetBytes < 1 || s.queueSize < 1 || !(s.timeoutSeconds > 0)) {
+        throw std::invalid_argument("--packet-size, --queue-size and --timeout must be positive.");
+    }
+    return s;
+}
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <cstdint>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Scheduler policies the WiFiSimulation classes are parameterized on.
+// Each policy only tracks backlogged users, so picking the next user costs
+// O(1) or O(log n) however many stations are idle.
+//
+// Policy interface:
+//   activate(user)         user has an arrived packet; no-op if already queued
+//   pickNext()             remove and return the next user to serve, -1 if none
+//   consume(user, bytes)   ask to send `bytes` more for a picked user; false = turn over
+//   onIdle(user)           user's queue drained
+//   setRate(user, bps)     current PHY rate of the user (channel-aware policies)
+//   setQuantum(bytes)      bytes a user may send per turn (deficit round-robin)
+//   save(out) / load(in)   whole policy state, for simulation snapshots (see snapshot.h)
+
+// Scheduler Policy Base Class: membership tracking and no-op hooks
+class SchedulerPolicyBase {
+protected:
+    std::vector<char> queued;   // User is waiting in the policy's active structure
+
+public:
+    explicit SchedulerPolicyBase(int userCount) : queued(userCount, 0) {}
+
+    bool isQueued(int user) const { return queued[user] != 0; }
+    bool consume(int, int) { return true; }
+    void onIdle(int) {}
+    void setRate(int, double) {}
+    void setQuantum(int) {}
+
+    template <typename Archive>
+    void save(Archive& out) const { out.putVector(queued); }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        size_t users = queued.size();
+        in.getVector(queued);
+        if (queued.size() != users) throw std::runtime_error("Snapshot scheduler has a different number of users.");
+    }
+};
+
+// Heap contents in pop order; re-pushing them restores the same pop sequence
+template <typename Heap, typename Archive>
+void saveHeap(const Heap& heap, Archive& out) {
+    out.put(static_cast<uint64_t>(heap.size()));
+    for (Heap pending = heap; !pending.empty(); pending.pop()) out.put(pending.top());
+}
+
+template <typename Heap, typename Archive>
+void loadHeap(Heap& heap, Archive& in) {
+    heap = Heap();
+    uint64_t n = in.template get<uint64_t>();
+    for (uint64_t i = 0; i < n; ++i) heap.push(in.template get<typename Heap::value_type>());
+}
+
+// Round-Robin Scheduler Class: intrusive FIFO of backlogged users
+class RoundRobinScheduler : public SchedulerPolicyBase {
+protected:
+    std::vector<int> nextInList;
+    int head;
+    int tail;
+
+    void pushBack(int user) {
+        nextInList[user] = -1;
+        if (tail == -1) head = user;
+        else nextInList[tail] = user;
+        tail = user;
+        queued[user] = 1;
+    }
+
+    int popFront() {
+        int user = head;
+        head = nextInList[user];
+        if (head == -1) tail = -1;
+        queued[user] = 0;
+        return user;
+    }
+
+public:
+    explicit RoundRobinScheduler(int userCount) : SchedulerPolicyBase(userCount), nextInList(userCount, -1), head(-1), tail(-1) {}
+
+    static const char* name() { return "rr"; }
+
+    bool empty() const { return head == -1; }
+
+    void activate(int user) {
+        if (!queued[user]) pushBack(user);
+    }
+
+    int pickNext() { return head == -1 ? -1 : popFront(); }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        SchedulerPolicyBase::save(out);
+        out.putVector(nextInList);
+        out.put(head);
+        out.put(tail);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        SchedulerPolicyBase::load(in);
+        in.getVector(nextInList);
+        in.get(head);
+        in.get(tail);
+    }
+};
+
+// Deficit Round-Robin Scheduler Class: each turn adds a byte quantum to the user's deficit
+class DeficitRoundRobinScheduler : public RoundRobinScheduler {
+private:
+    std::vector<int64_t> deficit;
+    int quantum;
+
+public:
+    explicit DeficitRoundRobinScheduler(int userCount, int quantumBytes = 1500)
+        : RoundRobinScheduler(userCount), deficit(userCount, 0), quantum(quantumBytes) {}
+
+    static const char* name() { return "drr"; }
+
+    void setQuantum(int quantumBytes) { quantum = quantumBytes; }
+
+    int pickNext() {
+        if (head == -1) return -1;
+        int user = popFront();
+        deficit[user] += quantum;
+        return user;
+    }
+
+    bool consume(int user, int bytes) {
+        if (deficit[user] < bytes) return false;
+        deficit[user] -= bytes;
+        return true;
+    }
+
+    void onIdle(int user) { deficit[user] = 0; }  // Idle users do not bank credit
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        RoundRobinScheduler::save(out);
+        out.putVector(deficit);
+        out.put(quantum);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        RoundRobinScheduler::load(in);
+        in.getVector(deficit);
+        in.get(quantum);
+    }
+};
+
+// Proportional-Fair Scheduler Class: serve max rate / average throughput.
+// All averages decay by the same factor each decision, which leaves the order
+// of unserved users unchanged, so averages are stored relative to a global
+// scale and only the served user's key moves: a plain heap suffices.
+class ProportionalFairScheduler : public SchedulerPolicyBase {
+private:
+    struct Entry {
+        double priority;
+        uint64_t order;     // Activation order, older first on ties
+        int user;
+        bool operator<(const Entry& o) const {
+            if (priority != o.priority) return priority < o.priority;
+            return order > o.order;
+        }
+    };
+
+    std::priority_queue<Entry> heap;
+    std::vector<double> rate;
+    std::vector<double> scaledAverage;  // Average throughput / scale
+    double scale;
+    double beta;                        // EWMA weight of the newest decision
+    uint64_t activations;
+
+    double priorityOf(int user) const { return rate[user] / scaledAverage[user]; }
+
+    // Fold the global scale back into the stored averages before it underflows
+    void renormalize() {
+        for (double& avg : scaledAverage) avg *= scale;
+        scale = 1.0;
+        std::priority_queue<Entry> rebuilt;
+        while (!heap.empty()) {
+            Entry e = heap.top();
+            heap.pop();
+            e.priority = priorityOf(e.user);
+            rebuilt.push(e);
+        }
+        heap.swap(rebuilt);
+    }
+
+public:
+    explicit ProportionalFairScheduler(int userCount, double ewmaWeight = 0.01)
+        : SchedulerPolicyBase(userCount), rate(userCount, 1.0), scaledAverage(userCount, 1.0),
+          scale(1.0), beta(ewmaWeight), activations(0) {}
+
+    static const char* name() { return "pf"; }
+
+    bool empty() const { return heap.empty(); }
+
+    void setRate(int user, double bps) { rate[user] = bps; }
+
+    void activate(int user) {
+        if (queued[user]) return;
+        queued[user] = 1;
+        heap.push(Entry{priorityOf(user), activations++, user});
+    }
+
+    int pickNext() {
+        if (heap.empty()) return -1;
+        int user = heap.top().user;
+        heap.pop();
+        queued[user] = 0;
+        scale *= (1.0 - beta);
+        if (scale < 1e-150) renormalize();
+        return user;
+    }
+
+    bool consume(int user, int bytes) {
+        scaledAverage[user] += beta * bytes * 8.0 / scale;
+        return true;
+    }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        SchedulerPolicyBase::save(out);
+        saveHeap(heap, out);
+        out.putVector(rate);
+        out.putVector(scaledAverage);
+        out.put(scale);
+        out.put(beta);
+        out.put(activations);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        SchedulerPolicyBase::load(in);
+        loadHeap(heap, in);
+        in.getVector(rate);
+        in.getVector(scaledAverage);
+        in.get(scale);
+        in.get(beta);
+        in.get(activations);
+    }
+};
+
+// Max-C/I Scheduler Class: always serve the backlogged user with the best rate
+class MaxRateScheduler : public SchedulerPolicyBase {
+private:
+    struct Entry {
+        double rate;
+        uint64_t order;
+        int user;
+        bool operator<(const Entry& o) const {
+            if (rate != o.rate) return rate < o.rate;
+            return order > o.order;
+        }
+    };
+
+    std::priority_queue<Entry> heap;
+    std::vector<double> rate;
+    uint64_t activations;
+
+public:
+    explicit MaxRateScheduler(int userCount) : SchedulerPolicyBase(userCount), rate(userCount, 1.0), activations(0) {}
+
+    static const char* name() { return "maxci"; }
+
+    bool empty() const { return heap.empty(); }
+
+    void setRate(int user, double bps) { rate[user] = bps; }
+
+    void activate(int user) {
+        if (queued[user]) return;
+        queued[user] = 1;
+        heap.push(Entry{rate[user], activations++, user});
+    }
+
+    int pickNext() {
+        if (heap.empty()) return -1;
+        int user = heap.top().user;
+        heap.pop();
+        queued[user] = 0;
+        return user;
+    }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        SchedulerPolicyBase::save(out);
+        saveHeap(heap, out);
+        out.putVector(rate);
+        out.put(activations);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        SchedulerPolicyBase::load(in);
+        loadHeap(heap, in);
+        in.getVector(rate);
+        in.get(activations);
+    }
+};
+
+// Compile-time scheduler selection from a runtime name: fn(SchedulerTag<Policy>())
+template <typename Policy>
+struct SchedulerTag {
+    typedef Policy type;
+};
+
+template <typename Fn>
+void withScheduler(const std::string& name, Fn&& fn) {
+    if (name == RoundRobinScheduler::name()) fn(SchedulerTag<RoundRobinScheduler>());
+    else if (name == DeficitRoundRobinScheduler::name()) fn(SchedulerTag<DeficitRoundRobinScheduler>());
+    else if (name == ProportionalFairScheduler::name()) fn(SchedulerTag<ProportionalFairScheduler>());
+    else if (name == MaxRateScheduler::name()) fn(SchedulerTag<MaxRateScheduler>());
+    else throw std::invalid_argument("Unknown scheduler: " + name + " (expected rr, drr, pf or maxci)");
+}
+
+// Parse an optional "--scheduler=<name>" argument; round-robin by default
+inline std::string parseSchedulerArgument(int argc, char* argv[]) {
+    const std::string flag = "--scheduler=";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, flag.size(), flag) == 0) return arg.substr(flag.size());
+    }
+    return RoundRobinScheduler::name();
+}
+
+#endif
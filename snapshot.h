@@ -0,0 +1,227 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Binary snapshots of a running simulation.
+// Components serialize themselves through save(out) / load(in) member
+// templates written against the archive interface below, so the headers that
+// define them do not depend on this one. Every value is stored raw in native
+// byte order: a snapshot restores bit-exactly (doubles, RNG state, event
+// sequence numbers) on the machine and build that wrote it, and is not meant
+// as an interchange format.
+//
+// File layout:
+//   magic "WIFISNP1", uint32 version, uint64 payload bytes, uint64 FNV-1a of the payload
+//   payload                    written by the simulation's saveState()
+// Files are written to a temporary name and renamed into place, so a job
+// killed mid-write leaves the previous snapshot intact.
+
+const char SNAPSHOT_MAGIC[8] = {'W', 'I', 'F', 'I', 'S', 'N', 'P', '1'};
+const uint32_t SNAPSHOT_VERSION = 4;
+
+inline uint64_t fnv1a(const char* data, size_t n) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+// Snapshot Writer Class: append-only payload buffer
+class SnapshotWriter {
+private:
+    std::vector<char> bytes;
+
+public:
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Snapshots store trivially copyable values only.");
+        const char* p = reinterpret_cast<const char*>(&value);
+        bytes.insert(bytes.end(), p, p + sizeof(T));
+    }
+
+    template <typename Vector>
+    void putVector(const Vector& values) {
+        put<uint64_t>(values.size());
+        for (const auto& v : values) put(v);
+    }
+
+    void putString(const std::string& s) {
+        put<uint64_t>(s.size());
+        bytes.insert(bytes.end(), s.begin(), s.end());
+    }
+
+    const std::vector<char>& payload() const { return bytes; }
+
+    // Write header + payload to `path` atomically
+    void save(const std::string& path) const {
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out) throw std::runtime_error("Could not write " + temporary + ".");
+            uint64_t size = bytes.size(), checksum = fnv1a(bytes.data(), bytes.size());
+            out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+            out.write(reinterpret_cast<const char*>(&SNAPSHOT_VERSION), sizeof(SNAPSHOT_VERSION));
+            out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!out.flush()) throw std::runtime_error("Could not write " + temporary + ".");
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Could not rename " + temporary + " to " + path + ": " + std::strerror(errno));
+        }
+    }
+};
+
+// Snapshot Reader Class: bounds-checked cursor over a payload
+class SnapshotReader {
+private:
+    std::vector<char> bytes;
+    size_t position;
+
+    void need(size_t n) const {
+        if (bytes.size() - position < n) throw std::runtime_error("Snapshot is truncated.");
+    }
+
+public:
+    explicit SnapshotReader(std::vector<char> payload) : bytes(std::move(payload)), position(0) {}
+
+    // Read and verify a snapshot file
+    static SnapshotReader open(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("Could not open " + path + ".");
+        char magic[sizeof(SNAPSHOT_MAGIC)];
+        uint32_t version = 0;
+        uint64_t size = 0, checksum = 0;
+        in.read(magic, sizeof(magic));
+        in.read(reinterpret_cast<char*>(&version), sizeof(version));
+        in.read(reinterpret_cast<char*>(&size), sizeof(size));
+        in.read(reinterpret_cast<char*>(&checksum), sizeof(checksum));
+        if (!in || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) throw std::runtime_error(path + " is not a snapshot.");
+        if (version != SNAPSHOT_VERSION) throw std::runtime_error(path + ": unsupported snapshot version " + std::to_string(version) + ".");
+
+        std::vector<char> payload((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (payload.size() != size) throw std::runtime_error(path + ": snapshot is truncated.");
+        if (fnv1a(payload.data(), payload.size()) != checksum) throw std::runtime_error(path + ": snapshot checksum mismatch.");
+        return SnapshotReader(std::move(payload));
+    }
+
+    template <typename T>
+    void get(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Snapshots store trivially copyable values only.");
+        need(sizeof(T));
+        std::memcpy(&value, bytes.data() + position, sizeof(T));
+        position += sizeof(T);
+    }
+
+    template <typename T>
+    T get() {
+        T value;
+        get(value);
+        return value;
+    }
+
+    template <typename Vector>
+    void getVector(Vector& values) {
+        uint64_t n = get<uint64_t>();
+        need(n);  // Cheap sanity bound before resizing: every element is at least one byte
+        values.resize(static_cast<size_t>(n));
+        for (auto& v : values) get(v);
+    }
+
+    std::string getString() {
+        uint64_t n = get<uint64_t>();
+        need(n);
+        std::string s(bytes.data() + position, static_cast<size_t>(n));
+        position += static_cast<size_t>(n);
+        return s;
+    }
+
+    bool atEnd() const { return position == bytes.size(); }
+};
+
+// Leading fields every simulation's saveState() writes first, so a driver can size the simulation before loading
+struct SnapshotInfo {
+    std::string model;      // Standard and compile-time configuration, checked on load
+    int userCount = 0;
+    uint64_t seed = 0;
+    double simulatedTime = 0;
+};
+
+template <typename Archive>
+void saveSnapshotInfo(Archive& out, const SnapshotInfo& info) {
+    out.putString(info.model);
+    out.put(info.userCount);
+    out.put(info.seed);
+    out.put(info.simulatedTime);
+}
+
+template <typename Archive>
+SnapshotInfo loadSnapshotInfo(Archive& in) {
+    SnapshotInfo info;
+    info.model = in.getString();
+    in.get(info.userCount);
+    in.get(info.seed);
+    in.get(info.simulatedTime);
+    return info;
+}
+
+// Info of a snapshot without consuming the caller's reader
+inline SnapshotInfo peekSnapshotInfo(SnapshotReader in) { return loadSnapshotInfo(in); }
+
+// Command-line options: --checkpoint=FILE [--checkpoint-every=S], --resume=FILE, --fork=FILE [--branches=N]
+struct CheckpointOptions {
+    std::string checkpoint;     // Base path; each run writes <base>.<users>
+    double every = 1.0;         // Simulated seconds between snapshots
+    std::string resume;         // Continue this snapshot to the end of its run
+    std::string fork;           // Run what-if branches of this snapshot
+    int branches = 8;
+};
+
+inline CheckpointOptions parseCheckpointArguments(int argc, char* argv[]) {
+    CheckpointOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 13, "--checkpoint=") == 0) opts.checkpoint = arg.substr(13);
+        else if (arg.compare(0, 19, "--checkpoint-every=") == 0) opts.every = std::atof(arg.c_str() + 19);
+        else if (arg.compare(0, 9, "--resume=") == 0) opts.resume = arg.substr(9);
+        else if (arg.compare(0, 7, "--fork=") == 0) opts.fork = arg.substr(7);
+        else if (arg.compare(0, 11, "--branches=") == 0) opts.branches = std::max(1, std::atoi(arg.c_str() + 11));
+    }
+    if (!(opts.every > 0)) throw std::invalid_argument("Checkpoint interval must be positive.");
+    return opts;
+}
+
+inline std::string checkpointPath(const std::string& base, int userCount) { return base + "." + std::to_string(userCount); }
+
+// Run to the end of the simulation, snapshotting it every `options.every` simulated seconds if asked to
+template <typename Simulation>
+void runCheckpointed(Simulation& simulation, const CheckpointOptions& options, int userCount) {
+    if (options.checkpoint.empty()) {
+        simulation.advance(std::numeric_limits<double>::infinity());
+        return;
+    }
+    std::string path = checkpointPath(options.checkpoint, userCount);
+    for (double next = simulation.now() + options.every; simulation.advance(next); next += options.every) {
+        SnapshotWriter out;
+        simulation.saveState(out);
+        out.save(path);
+    }
+}
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Online statistics updated in O(1) per packet and mergeable across replications.
+
+// Streaming Stats Class: Welford mean/variance plus min/max
+class StreamingStats {
+private:
+    uint64_t n;
+    double meanValue;
+    double m2;          // Sum of squared deviations from the mean
+    double minValue;
+    double maxValue;
+
+public:
+    StreamingStats() : n(0), meanValue(0), m2(0),
+                       minValue(std::numeric_limits<double>::infinity()),
+                       maxValue(-std::numeric_limits<double>::infinity()) {}
+
+    // Rebuild from moments computed elsewhere (e.g. a batch metrics kernel)
+    static StreamingStats fromMoments(uint64_t count, double mean, double sumSquaredDeviations, double min, double max) {
+        StreamingStats s;
+        if (count == 0) return s;
+        s.n = count;
+        s.meanValue = mean;
+        s.m2 = sumSquaredDeviations;
+        s.minValue = min;
+        s.maxValue = max;
+        return s;
+    }
+
+    void record(double x) {
+        n++;
+        double delta = x - meanValue;
+        meanValue += delta / n;
+        m2 += delta * (x - meanValue);
+        if (x < minValue) minValue = x;
+        if (x > maxValue) maxValue = x;
+    }
+
+    // Chan et al. parallel combination
+    void merge(const StreamingStats& other) {
+        if (other.n == 0) return;
+        if (n == 0) { *this = other; return; }
+        uint64_t total = n + other.n;
+        double delta = other.meanValue - meanValue;
+        meanValue += delta * other.n / total;
+        m2 += other.m2 + delta * delta * (static_cast<double>(n) * other.n / total);
+        n = total;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    uint64_t count() const { return n; }
+    double mean() const { return meanValue; }
+    double sum() const { return meanValue * n; }
+    double variance() const { return n > 1 ? m2 / (n - 1) : 0; }
+    double stddev() const { return std::sqrt(variance()); }
+    double min() const { return n ? minValue : 0; }
+    double max() const { return n ? maxValue : 0; }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(n);
+        out.put(meanValue);
+        out.put(m2);
+        out.put(minValue);
+        out.put(maxValue);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        in.get(n);
+        in.get(meanValue);
+        in.get(m2);
+        in.get(minValue);
+        in.get(maxValue);
+    }
+};
+
+// Latency Histogram Class: HDR-style log-linear buckets over integer nanoseconds.
+// Values below 128 ns are exact; above that each power of two is split into 64
+// sub-buckets, so any quantile is within 1/64 (~1.6%) relative error.
+class LatencyHistogram {
+private:
+    static const int SUB_BUCKET_BITS = 6;
+    static const uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+
+    std::vector<uint64_t> counts;   // Grows lazily to the largest bucket touched
+    uint64_t total;
+
+    static size_t indexOf(uint64_t v) {
+        if (v < 2 * SUB_BUCKETS) return static_cast<size_t>(v);
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - SUB_BUCKET_BITS;
+        return static_cast<size_t>(shift) * SUB_BUCKETS + (v >> shift);
+    }
+
+    // Midpoint of the value range covered by a bucket
+    static double valueOf(size_t index) {
+        if (index < 2 * SUB_BUCKETS) return static_cast<double>(index);
+        uint64_t shift = index / SUB_BUCKETS - 1;
+        uint64_t top = index % SUB_BUCKETS + SUB_BUCKETS;
+        double lower = static_cast<double>(top << shift);
+        return lower + (static_cast<double>(1ULL << shift) - 1) / 2.0;
+    }
+
+public:
+    LatencyHistogram() : total(0) {}
+
+    // Bucket of a nanosecond value; batch kernels compute the same index themselves
+    static size_t bucketOf(uint64_t nanos) { return indexOf(nanos); }
+
+    // Add per-bucket counts indexed like bucketOf()
+    void addBuckets(const uint64_t* bins, size_t n) {
+        if (n > counts.size()) counts.resize(n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            counts[i] += bins[i];
+            total += bins[i];
+        }
+    }
+
+    void recordNanos(uint64_t v, uint64_t times = 1) {
+        size_t idx = indexOf(v);
+        if (idx >= counts.size()) counts.resize(idx + 1, 0);
+        counts[idx] += times;
+        total += times;
+    }
+
+    void record(double seconds) {
+        recordNanos(seconds <= 0 ? 0 : static_cast<uint64_t>(seconds * 1e9 + 0.5));
+    }
+
+    void merge(const LatencyHistogram& other) {
+        if (other.counts.size() > counts.size()) counts.resize(other.counts.size(), 0);
+        for (size_t i = 0; i < other.counts.size(); ++i) counts[i] += other.counts[i];
+        total += other.total;
+    }
+
+    uint64_t count() const { return total; }
+
+    // Per-bucket counts indexed like bucketOf(), trailing empty buckets not included
+    const std::vector<uint64_t>& bucketCounts() const { return counts; }
+
+    // Value (seconds) at quantile q in [0, 1]
+    double quantile(double q) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * total));
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) return valueOf(i) * 1e-9;
+        }
+        return valueOf(counts.size() - 1) * 1e-9;
+    }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.putVector(counts);
+        out.put(total);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        in.getVector(counts);
+        in.get(total);
+    }
+};
+
+// Latency Stats Class: moments and quantiles of packet latency (seconds)
+class LatencyStats {
+private:
+    StreamingStats moments;
+    LatencyHistogram histogram;
+
+public:
+    void record(double latencySeconds) {
+        moments.record(latencySeconds);
+        histogram.record(latencySeconds);
+    }
+
+    void merge(const LatencyStats& other) {
+        moments.merge(other.moments);
+        histogram.merge(other.histogram);
+    }
+
+    // Fold in a batch summarized outside record() (moments + bucket counts)
+    void merge(const StreamingStats& batchMoments, const uint64_t* bins, size_t n) {
+        moments.merge(batchMoments);
+        histogram.addBuckets(bins, n);
+    }
+
+    uint64_t count() const { return moments.count(); }
+    double mean() const { return moments.mean(); }
+    double sum() const { return moments.sum(); }
+    double stddev() const { return moments.stddev(); }
+    double min() const { return moments.min(); }
+    double max() const { return moments.max(); }
+    // Bucket midpoints can lie outside the observed range, so the estimate is clamped to [min, max]
+    double quantile(double q) const {
+        if (count() == 0) return 0;
+        return std::min(std::max(histogram.quantile(q), moments.min()), moments.max());
+    }
+
+    const StreamingStats& getMoments() const { return moments; }
+    const LatencyHistogram& getHistogram() const { return histogram; }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        moments.save(out);
+        histogram.save(out);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        moments.load(in);
+        histogram.load(in);
+    }
+};
+
+#endif
@@ -0,0 +1,319 @@
+#ifndef STEADY_STATE_H
+#define STEADY_STATE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "stats.h"
+#include "sweep.h"
+
+// Warm-up truncation and sequential stopping for one simulation run.
+// Delivered packets feed an MSER-5 detector on their latency: batches of five
+// packets are averaged and the truncation point d that minimizes the
+// marginal standard error of the remaining batch means is recomputed as data
+// arrive. Once d falls in the first half of the series the start-up transient
+// is over: the simulation discards everything measured so far and starts
+// measuring. From then on throughput and latency are tracked by batch means
+// with a fixed number of batches (the batch size doubles whenever the count
+// reaches twice the minimum, which keeps batches long enough to be nearly
+// independent), and the run stops as soon as the 95% confidence interval of
+// both is within the requested fraction of their means.
+
+// Command-line options: --steady-state [--ci-precision=F] [--mser-batch=N] [--min-batches=N]
+struct SteadyStateOptions {
+    bool enabled = false;
+    double precision = 0.05;    // Target CI half-width relative to the mean, throughput and latency
+    int mserBatch = 5;          // Packets per MSER batch (MSER-5)
+    int minBatches = 20;        // Batch means needed before the stopping rule applies
+};
+
+inline SteadyStateOptions parseSteadyStateArguments(int argc, char* argv[]) {
+    SteadyStateOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--steady-state") opts.enabled = true;
+        else if (arg.compare(0, 15, "--ci-precision=") == 0) opts.precision = std::atof(arg.c_str() + 15);
+        else if (arg.compare(0, 13, "--mser-batch=") == 0) opts.mserBatch = std::atoi(arg.c_str() + 13);
+        else if (arg.compare(0, 14, "--min-batches=") == 0) opts.minBatches = std::atoi(arg.c_str() + 14);
+    }
+    if (!(opts.precision > 0) || opts.mserBatch < 1 || opts.minBatches < 2) {
+        throw std::invalid_argument("Steady-state options need a positive precision, --mser-batch >= 1 and --min-batches >= 2.");
+    }
+    return opts;
+}
+
+// MSER truncation point of a series: the d minimizing sum_{i>=d}(y_i - mean_d)^2 / (n - d)^2,
+// searched over d <= n - minTail; returns n if the series is shorter than minTail
+inline size_t mserTruncation(const std::vector<double>& y, size_t minTail = 5) {
+    size_t n = y.size();
+    if (n < minTail) return n;
+    double centre = 0;  // Centred sums keep the running variance accurate for large latencies
+    for (double v : y) centre += v;
+    centre /= n;
+
+    size_t best = 0;
+    double bestValue = std::numeric_limits<double>::infinity(), sum = 0, squares = 0;
+    for (size_t d = n; d-- > 0;) {
+        double v = y[d] - centre;
+        sum += v;
+        squares += v * v;
+        size_t m = n - d;
+        if (m < minTail) continue;
+        double value = (squares - sum * sum / m) / (static_cast<double>(m) * m);
+        if (value <= bestValue) {  // Ties go to the smaller d
+            bestValue = value;
+            best = d;
+        }
+    }
+    return best;
+}
+
+// MSER Detector Class: fires once the MSER truncation point lies in the first half of the batch means
+class MserDetector {
+private:
+    static const size_t MAX_BATCHES = 1 << 16;  // Batches are merged in pairs beyond this, bounding memory
+
+    size_t batchSize;
+    std::vector<double> means;
+    double batchSum;
+    size_t inBatch;
+    size_t nextCheck;       // Series length of the next test; tests are ~10% apart, so the cost stays linear
+    bool fired;
+
+public:
+    explicit MserDetector(size_t packetsPerBatch = 5)
+        : batchSize(packetsPerBatch), batchSum(0), inBatch(0), nextCheck(20), fired(false) {}
+
+    bool done() const { return fired; }
+
+    // Add one observation; true exactly once, when the transient is judged over
+    bool record(double x) {
+        if (fired) return false;
+        batchSum += x;
+        if (++inBatch < batchSize) return false;
+        means.push_back(batchSum / batchSize);
+        batchSum = 0;
+        inBatch = 0;
+
+        if (means.size() == MAX_BATCHES) {
+            for (size_t i = 0; i < MAX_BATCHES / 2; ++i) means[i] = (means[2 * i] + means[2 * i + 1]) / 2;
+            means.resize(MAX_BATCHES / 2);
+            batchSize *= 2;
+            nextCheck = std::min(nextCheck, means.size());
+        }
+        if (means.size() < nextCheck) return false;
+        nextCheck = means.size() + std::max<size_t>(1, means.size() / 10);
+        if (mserTruncation(means) > means.size() / 2) return false;
+        fired = true;
+        std::vector<double>().swap(means);
+        return true;
+    }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(static_cast<uint64_t>(batchSize));
+        out.putVector(means);
+        out.put(batchSum);
+        out.put(static_cast<uint64_t>(inBatch));
+        out.put(static_cast<uint64_t>(nextCheck));
+        out.put(fired);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        batchSize = static_cast<size_t>(in.template get<uint64_t>());
+        in.getVector(means);
+        in.get(batchSum);
+        inBatch = static_cast<size_t>(in.template get<uint64_t>());
+        nextCheck = static_cast<size_t>(in.template get<uint64_t>());
+        in.get(fired);
+    }
+};
+
+// Batch Means Class: throughput and mean latency over K..2K batches of equal packet count
+class BatchMeans {
+private:
+    struct Batch {
+        double packets;
+        double latencySum;
+        double duration;    // Simulated seconds from the previous batch's last delivery
+    };
+
+    size_t minBatches;
+    size_t initialPackets;  // Smallest batch; short batches of simultaneous deliveries have no usable duration
+    size_t batchPackets;
+    std::vector<Batch> batches;
+    Batch current;
+    double lastTime;
+
+    // 95% half-width of the mean of `values` relative to that mean
+    static double relativeHalfWidth(const std::vector<double>& values) {
+        StreamingStats s;
+        for (double v : values) s.record(v);
+        if (s.mean() == 0) return std::numeric_limits<double>::infinity();
+        return studentT95(values.size() - 1) * s.stddev() / std::sqrt(static_cast<double>(values.size())) / std::fabs(s.mean());
+    }
+
+public:
+    explicit BatchMeans(size_t minimumBatches = 20, size_t initialBatchPackets = 32)
+        : minBatches(minimumBatches), initialPackets(initialBatchPackets), batchPackets(initialBatchPackets), current{0, 0, 0}, lastTime(0) {}
+
+    void start(double now) {
+        batches.clear();
+        batchPackets = initialPackets;
+        current = Batch{0, 0, 0};
+        lastTime = now;
+    }
+
+    // Add one delivery; true when it completed a batch
+    bool record(double now, double latency) {
+        current.packets++;
+        current.latencySum += latency;
+        if (current.packets < batchPackets) return false;
+        current.duration = now - lastTime;
+        lastTime = now;
+        batches.push_back(current);
+        current = Batch{0, 0, 0};
+        if (batches.size() == 2 * minBatches) {
+            for (size_t i = 0; i < minBatches; ++i) {
+                const Batch& a = batches[2 * i];
+                const Batch& b = batches[2 * i + 1];
+                batches[i] = Batch{a.packets + b.packets, a.latencySum + b.latencySum, a.duration + b.duration};
+            }
+            batches.resize(minBatches);
+            batchPackets *= 2;
+        }
+        return true;
+    }
+
+    size_t count() const { return batches.size(); }
+
+    // Relative CI half-widths of throughput (packets per second) and mean latency
+    double throughputPrecision() const {
+        std::vector<double> rates;
+        for (const Batch& b : batches) rates.push_back(b.duration > 0 ? b.packets / b.duration : 0);
+        return relativeHalfWidth(rates);
+    }
+
+    double latencyPrecision() const {
+        std::vector<double> latencies;
+        for (const Batch& b : batches) latencies.push_back(b.latencySum / b.packets);
+        return relativeHalfWidth(latencies);
+    }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(static_cast<uint64_t>(minBatches));
+        out.put(static_cast<uint64_t>(initialPackets));
+        out.put(static_cast<uint64_t>(batchPackets));
+        out.putVector(batches);
+        out.put(current);
+        out.put(lastTime);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        minBatches = static_cast<size_t>(in.template get<uint64_t>());
+        initialPackets = static_cast<size_t>(in.template get<uint64_t>());
+        batchPackets = static_cast<size_t>(in.template get<uint64_t>());
+        in.getVector(batches);
+        in.get(current);
+        in.get(lastTime);
+    }
+};
+
+// Steady State Monitor Class: warm-up detection, then the stopping rule, driven by delivered packets
+class SteadyStateMonitor {
+public:
+    enum class Transition { None, WarmedUp, Converged };
+
+private:
+    SteadyStateOptions options;
+    MserDetector detector;
+    BatchMeans batchMeans;
+    double warmupEnd;       // Simulated time measurement started
+    uint64_t discarded;     // Packets delivered during warm-up
+    bool converged;
+
+public:
+    explicit SteadyStateMonitor(const SteadyStateOptions& opts = SteadyStateOptions())
+        : options(opts), detector(static_cast<size_t>(opts.mserBatch)), batchMeans(static_cast<size_t>(opts.minBatches)),
+          warmupEnd(0), discarded(0), converged(false) {}
+
+    bool enabled() const { return options.enabled; }
+    bool warmedUp() const { return detector.done(); }
+    bool hasConverged() const { return converged; }
+    double measurementStart() const { return warmupEnd; }
+    uint64_t warmupPackets() const { return discarded; }
+    size_t batches() const { return batchMeans.count(); }
+
+    // One delivered packet. WarmedUp: reset the run's statistics now. Converged: stop the run.
+    Transition record(double now, double latency) {
+        if (!options.enabled || converged) return Transition::None;
+        if (!detector.done()) {
+            discarded++;
+            if (!detector.record(latency)) return Transition::None;
+            warmupEnd = now;
+            batchMeans.start(now);
+            return Transition::WarmedUp;
+        }
+        if (!batchMeans.record(now, latency)) return Transition::None;
+        if (batchMeans.count() < static_cast<size_t>(options.minBatches)) return Transition::None;
+        if (batchMeans.latencyPrecision() > options.precision || batchMeans.throughputPrecision() > options.precision) return Transition::None;
+        converged = true;
+        return Transition::Converged;
+    }
+
+    // Copy the outcome into a run's result
+    void annotate(ReplicationResult& result, double endTime) const {
+        if (!options.enabled) return;
+        result.steadyState = true;
+        result.warmedUp = detector.done();
+        result.warmupSeconds = warmupEnd;
+        result.warmupPackets = detector.done() ? discarded : 0;
+        result.measuredSeconds = endTime - warmupEnd;
+        result.converged = converged;
+    }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(options);
+        detector.save(out);
+        batchMeans.save(out);
+        out.put(warmupEnd);
+        out.put(discarded);
+        out.put(converged);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        in.get(options);
+        detector.load(in);
+        batchMeans.load(in);
+        in.get(warmupEnd);
+        in.get(discarded);
+        in.get(converged);
+    }
+};
+
+// One line on the warm-up and stopping outcome of a run; nothing if the monitor was off
+inline void printSteadyState(std::ostream& out, const ReplicationResult& result) {
+    if (!result.steadyState) return;
+    out << std::fixed << std::setprecision(3);
+    if (!result.warmedUp) {
+        out << "Steady State: not reached, statistics cover the whole run\n";
+        return;
+    }
+    out << "Warm-up: " << result.warmupSeconds << " s (" << result.warmupPackets << " packets discarded), measured "
+        << result.measuredSeconds << " s, " << (result.converged ? "stopped at" : "ended before") << " the confidence target\n";
+}
+
+#endif
@@ -0,0 +1,358 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "rng.h"
+#include "stats.h"
+
+// Parallel Monte-Carlo sweep runner: fans independent replications across a
+// work-stealing thread pool and aggregates mean / percentile / confidence interval.
+
+// Work-Stealing Thread Pool Class
+class ThreadPool {
+private:
+    struct WorkerQueue {
+        std::deque<std::function<void()>> tasks;
+        std::mutex lock;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queued;       // Submitted but not yet picked up
+    std::atomic<size_t> outstanding;  // Submitted but not yet finished
+    std::atomic<size_t> nextQueue;
+    bool done;
+    std::mutex idleLock;
+    std::condition_variable workAvailable;
+    std::condition_variable allFinished;
+
+    // Owner takes from the back of its own deque (LIFO, cache-warm)
+    bool popLocal(size_t self, std::function<void()>& task) {
+        WorkerQueue& q = *queues[self];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tasks.empty()) return false;
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    // Thieves take from the front of a victim's deque (oldest, largest-grained work)
+    bool steal(size_t self, std::function<void()>& task) {
+        for (size_t n = 1; n < queues.size(); ++n) {
+            WorkerQueue& q = *queues[(self + n) % queues.size()];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.tasks.empty()) continue;
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(size_t self) {
+        while (true) {
+            std::function<void()> task;
+            if (popLocal(self, task) || steal(self, task)) {
+                queued--;
+                task();
+                if (--outstanding == 0) {
+                    std::lock_guard<std::mutex> guard(idleLock);
+                    allFinished.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lk(idleLock);
+            workAvailable.wait(lk, [&] { return done || queued.load() > 0; });
+            if (done && queued.load() == 0) return;
+        }
+    }
+
+public:
+    explicit ThreadPool(unsigned threadCount = 0) : queued(0), outstanding(0), nextQueue(0), done(false) {
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threadCount; ++i) queues.emplace_back(new WorkerQueue());
+        for (unsigned i = 0; i < threadCount; ++i) threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(idleLock);
+            done = true;
+        }
+        workAvailable.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return threads.size(); }
+
+    // Distribute tasks round-robin over the per-worker deques; idle workers steal the rest.
+    // The counters go up before the push, so a worker that takes the task at once never sees them wrap.
+    void submit(std::function<void()> task) {
+        WorkerQueue& q = *queues[nextQueue++ % queues.size()];
+        outstanding++;
+        queued++;
+        {
+            std::lock_guard<std::mutex> guard(q.lock);
+            q.tasks.push_back(std::move(task));
+        }
+        std::lock_guard<std::mutex> guard(idleLock);
+        workAvailable.notify_one();
+    }
+
+    // Block until every submitted task has finished
+    void wait() {
+        std::unique_lock<std::mutex> lk(idleLock);
+        allFinished.wait(lk, [&] { return outstanding.load() == 0; });
+    }
+};
+
+// One independent simulation run
+struct Replication {
+    std::string standard;               // "wifi4", "wifi5" or "wifi6"
+    int userCount;
+    uint64_t seed;
+    std::vector<double> subChannels;    // Sub-channel widths in MHz (WiFi 6 only)
+};
+
+// Raw metrics of one run (aggregate throughput, no display adjustments)
+struct ReplicationResult {
+    double throughputMbps = 0;
+    double avgLatencyMs = 0;
+    double maxLatencyMs = 0;
+    double p50LatencyMs = 0;
+    double p99LatencyMs = 0;
+    double p999LatencyMs = 0;
+    double droppedPackets = 0;
+    uint64_t simulatedEvents = 0;   // Discrete events the engine processed (simulator speed, not network behaviour)
+    bool steadyState = false;       // Warm-up truncation and the stopping rule were on (steady_state.h)
+    bool warmedUp = false;          // The warm-up detector fired; otherwise the metrics cover the whole run
+    double warmupSeconds = 0;       // Simulated time discarded as warm-up
+    uint64_t warmupPackets = 0;     // Deliveries discarded with it
+    double measuredSeconds = 0;     // Simulated time the metrics cover
+    bool converged = false;         // Stopped on the confidence target rather than at the end of the traffic
+    LatencyStats latency;   // Full per-packet distribution, merged across replications by the sweep
+
+    void setLatency(const LatencyStats& stats) {
+        latency = stats;
+        avgLatencyMs = stats.mean() * 1e3;
+        maxLatencyMs = stats.max() * 1e3;
+        p50LatencyMs = stats.quantile(0.50) * 1e3;
+        p99LatencyMs = stats.quantile(0.99) * 1e3;
+        p999LatencyMs = stats.quantile(0.999) * 1e3;
+    }
+};
+
+// Summary of one metric across replications
+struct SummaryStat {
+    double mean = 0;
+    double stddev = 0;
+    double p50 = 0;
+    double p95 = 0;
+    double ciHalfWidth = 0;  // 95% confidence interval half-width of the mean
+};
+
+// Aggregated sweep point
+struct SweepPoint {
+    Replication key;
+    size_t replications = 0;
+    SummaryStat throughput;
+    SummaryStat avgLatency;
+    SummaryStat maxLatency;
+    SummaryStat dropped;
+    LatencyStats pooledLatency;     // Every packet of every replication in the group
+    bool steadyState = false;
+    SummaryStat warmup;
+    SummaryStat measured;
+    size_t converged = 0;           // Replications stopped by the confidence target
+};
+
+// Two-sided 95% Student-t critical value
+inline double studentT95(size_t degreesOfFreedom) {
+    static const double table[] = {0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (degreesOfFreedom == 0) return 0;
+    if (degreesOfFreedom <= 30) return table[degreesOfFreedom];
+    return 1.96;
+}
+
+// Linear-interpolated percentile of an already sorted sample
+inline double percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    double pos = q * (sorted.size() - 1);
+    size_t lo = static_cast<size_t>(pos);
+    size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (pos - lo) * (sorted[hi] - sorted[lo]);
+}
+
+inline SummaryStat summarize(std::vector<double> values) {
+    SummaryStat s;
+    if (values.empty()) return s;
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (double v : values) sum += v;
+    s.mean = sum / values.size();
+    double sq = 0;
+    for (double v : values) sq += (v - s.mean) * (v - s.mean);
+    s.stddev = values.size() > 1 ? std::sqrt(sq / (values.size() - 1)) : 0;
+    s.p50 = percentile(values, 0.50);
+    s.p95 = percentile(values, 0.95);
+    s.ciHalfWidth = studentT95(values.size() - 1) * s.stddev / std::sqrt(static_cast<double>(values.size()));
+    return s;
+}
+
+// Sweep Runner Class
+class SweepRunner {
+private:
+    ThreadPool pool;
+
+public:
+    explicit SweepRunner(unsigned threadCount = 0) : pool(threadCount) {}
+
+    size_t threadCount() const { return pool.size(); }
+
+    // Run simulate(const Replication&) -> ReplicationResult for every replication in parallel.
+    // Results come back in input order; the first exception thrown by a replication is rethrown.
+    template <typename Simulate>
+    std::vector<ReplicationResult> run(const std::vector<Replication>& replications, Simulate simulate) {
+        std::vector<ReplicationResult> results(replications.size());
+        std::exception_ptr firstError;
+        std::mutex errorLock;
+
+        for (size_t i = 0; i < replications.size(); ++i) {
+            pool.submit([&, i] {
+                try {
+                    results[i] = simulate(replications[i]);
+                } catch (...) {
+                    std::lock_guard<std::mutex> guard(errorLock);
+                    if (!firstError) firstError = std::current_exception();
+                }
+            });
+        }
+        pool.wait();
+
+        if (firstError) std::rethrow_exception(firstError);
+        return results;
+    }
+
+    // Group replications that differ only by seed and summarize each group
+    static std::vector<SweepPoint> aggregate(const std::vector<Replication>& replications,
+                                             const std::vector<ReplicationResult>& results) {
+        typedef std::tuple<std::string, int, std::vector<double>> Key;
+        std::map<Key, std::vector<size_t>> groups;
+        for (size_t i = 0; i < replications.size(); ++i) {
+            const Replication& r = replications[i];
+            groups[Key(r.standard, r.userCount, r.subChannels)].push_back(i);
+        }
+
+        std::vector<SweepPoint> points;
+        for (auto& group : groups) {
+            SweepPoint p;
+            std::vector<double> tput, avg, mx, drop, warm, meas;
+            for (size_t i : group.second) {
+                tput.push_back(results[i].throughputMbps);
+                avg.push_back(results[i].avgLatencyMs);
+                mx.push_back(results[i].maxLatencyMs);
+                drop.push_back(results[i].droppedPackets);
+                p.pooledLatency.merge(results[i].latency);
+                warm.push_back(results[i].warmupSeconds);
+                meas.push_back(results[i].measuredSeconds);
+                p.steadyState = p.steadyState || results[i].steadyState;
+                if (results[i].converged) p.converged++;
+            }
+            p.key = replications[group.second.front()];
+            p.replications = group.second.size();
+            p.throughput = summarize(tput);
+            p.avgLatency = summarize(avg);
+            p.maxLatency = summarize(mx);
+            p.dropped = summarize(drop);
+            p.warmup = summarize(warm);
+            p.measured = summarize(meas);
+            points.push_back(p);
+        }
+        return points;
+    }
+
+    static void printSummary(const std::vector<SweepPoint>& points, std::ostream& out) {
+        out << std::fixed << std::setprecision(3);
+        for (const SweepPoint& p : points) {
+            out << p.key.standard << " users=" << p.key.userCount;
+            if (!p.key.subChannels.empty()) {
+                out << " subchannels=";
+                for (size_t i = 0; i < p.key.subChannels.size(); ++i) out << (i ? "/" : "") << p.key.subChannels[i];
+            }
+            out << " replications=" << p.replications << "\n";
+            out << "  Throughput (Mbps):    mean " << p.throughput.mean << " +/- " << p.throughput.ciHalfWidth
+                << "  p50 " << p.throughput.p50 << "  p95 " << p.throughput.p95 << "\n";
+            out << "  Average Latency (ms): mean " << p.avgLatency.mean << " +/- " << p.avgLatency.ciHalfWidth
+                << "  p50 " << p.avgLatency.p50 << "  p95 " << p.avgLatency.p95 << "\n";
+            out << "  Maximum Latency (ms): mean " << p.maxLatency.mean << " +/- " << p.maxLatency.ciHalfWidth
+                << "  p50 " << p.maxLatency.p50 << "  p95 " << p.maxLatency.p95 << "\n";
+            out << "  Pooled Latency (ms):  p50 " << p.pooledLatency.quantile(0.50) * 1e3
+                << "  p99 " << p.pooledLatency.quantile(0.99) * 1e3
+                << "  p99.9 " << p.pooledLatency.quantile(0.999) * 1e3 << "\n";
+            out << "  Dropped Packets:      mean " << p.dropped.mean << "\n";
+            if (p.steadyState) {
+                out << "  Warm-up (s):          mean " << p.warmup.mean << "  measured " << p.measured.mean
+                    << "  converged " << p.converged << "/" << p.replications << "\n";
+            }
+        }
+    }
+};
+
+// Cartesian product of user counts x sub-channel sets x seeds; replication s gets replicationSeed(baseSeed, s)
+inline std::vector<Replication> buildSweep(const std::string& standard, const std::vector<int>& userCounts,
+                                           int seedCount, uint64_t baseSeed,
+                                           const std::vector<std::vector<double>>& subChannelSets = {{}}) {
+    std::vector<Replication> replications;
+    for (int users : userCounts) {
+        for (const auto& subChannels : subChannelSets) {
+            for (int s = 0; s < seedCount; ++s) {
+                replications.push_back(Replication{standard, users, replicationSeed(baseSeed, s), subChannels});
+            }
+        }
+    }
+    return replications;
+}
+
+// Command-line options: --sweep [--seeds=N] [--threads=N]
+struct SweepOptions {
+    bool enabled = false;
+    int seeds = 30;
+    unsigned threads = 0;   // 0 = one per hardware thread
+};
+
+inline SweepOptions parseSweepArguments(int argc, char* argv[]) {
+    SweepOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sweep") opts.enabled = true;
+        else if (arg.compare(0, 8, "--seeds=") == 0) opts.seeds = std::max(1, std::atoi(arg.c_str() + 8));
+        else if (arg.compare(0, 10, "--threads=") == 0) opts.threads = static_cast<unsigned>(std::atoi(arg.c_str() + 10));
+    }
+    return opts;
+}
+
+#endif
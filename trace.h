@@ -0,0 +1,289 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Packet arrival traces for replay.
+// Traces are stored in a station-grouped binary file that is mmapped, so
+// traffic sources read records straight out of the page cache and replaying
+// a multi-GB capture does not load it into memory. The CSV importer makes two
+// passes over a capture export and writes through a mapping of the output,
+// so importing needs memory only per station, not per record.
+//
+// File layout (native byte order):
+//   TraceFileHeader            magic, version, station count, record count
+//   uint64_t[stations + 1]     first record of each station; the last entry is the record count
+//   TraceRecord[records]       grouped by station, timestamps ascending within a station
+
+// One recorded arrival: seconds since the start of the trace, station, frame size
+struct TraceRecord {
+    double timestamp;
+    uint32_t station;
+    uint32_t bytes;
+};
+
+const char TRACE_MAGIC[8] = {'W', 'I', 'F', 'I', 'T', 'R', 'C', '1'};
+const uint32_t TRACE_VERSION = 1;
+
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t stations;
+    uint64_t records;
+};
+
+inline size_t traceFileSize(uint64_t stations, uint64_t records) {
+    return sizeof(TraceFileHeader) + (stations + 1) * sizeof(uint64_t) + records * sizeof(TraceRecord);
+}
+
+// Mapped File Class: RAII read-only or read-write shared mapping of a whole file
+class MappedFile {
+private:
+    void* base;
+    size_t length;
+
+    MappedFile(int fd, size_t size, bool writable, const std::string& path) : base(nullptr), length(size) {
+        if (length == 0) return;
+        base = mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            base = nullptr;
+            throw std::runtime_error("Could not map " + path + ": " + std::strerror(errno));
+        }
+    }
+
+    static int openOrThrow(const std::string& path, int flags) {
+        int fd = ::open(path.c_str(), flags, 0644);
+        if (fd < 0) throw std::runtime_error("Could not open " + path + ": " + std::strerror(errno));
+        return fd;
+    }
+
+public:
+    ~MappedFile() {
+        if (base) munmap(base, length);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    static std::unique_ptr<MappedFile> openRead(const std::string& path) {
+        int fd = openOrThrow(path, O_RDONLY);
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not stat " + path + ": " + std::strerror(errno));
+        }
+        try {
+            std::unique_ptr<MappedFile> file(new MappedFile(fd, static_cast<size_t>(info.st_size), false, path));
+            ::close(fd);  // The mapping keeps the file open
+            return file;
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    // Create (or truncate) `path` at `size` bytes and map it writable
+    static std::unique_ptr<MappedFile> create(const std::string& path, size_t size) {
+        int fd = openOrThrow(path, O_RDWR | O_CREAT | O_TRUNC);
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not size " + path + ": " + std::strerror(errno));
+        }
+        try {
+            std::unique_ptr<MappedFile> file(new MappedFile(fd, size, true, path));
+            ::close(fd);
+            return file;
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    const char* data() const { return static_cast<const char*>(base); }
+    char* data() { return static_cast<char*>(base); }
+    size_t size() const { return length; }
+};
+
+// Trace Arrivals Class: station-grouped records, held in memory or read through a file mapping
+class TraceArrivals {
+private:
+    std::vector<TraceRecord> storage;       // In-memory traces only
+    std::vector<uint64_t> offsetStorage;
+    std::unique_ptr<MappedFile> mapping;    // Mapped traces only
+    const TraceRecord* records;
+    const uint64_t* offsets;                // Records of station s are [offsets[s], offsets[s + 1])
+    int stationCount;
+    size_t recordCount;
+
+    TraceArrivals() : records(nullptr), offsets(nullptr), stationCount(0), recordCount(0) {}
+
+public:
+    // In-memory trace from records in any order (sorted by station, then timestamp)
+    explicit TraceArrivals(std::vector<TraceRecord> unsorted) : TraceArrivals() {
+        storage = std::move(unsorted);
+        std::stable_sort(storage.begin(), storage.end(), [](const TraceRecord& a, const TraceRecord& b) {
+            return a.station != b.station ? a.station < b.station : a.timestamp < b.timestamp;
+        });
+        size_t stations = storage.empty() ? 0 : storage.back().station + 1;
+        offsetStorage.assign(stations + 1, 0);
+        for (const TraceRecord& r : storage) offsetStorage[r.station + 1]++;
+        for (size_t s = 0; s < stations; ++s) offsetStorage[s + 1] += offsetStorage[s];
+        records = storage.data();
+        offsets = offsetStorage.data();
+        stationCount = static_cast<int>(stations);
+        recordCount = storage.size();
+    }
+
+    TraceArrivals(const TraceArrivals&) = delete;
+    TraceArrivals& operator=(const TraceArrivals&) = delete;
+
+    // Map a binary trace file; only the header and offsets are checked, records are paged in on use
+    static std::shared_ptr<const TraceArrivals> open(const std::string& path) {
+        std::shared_ptr<TraceArrivals> trace(new TraceArrivals());
+        trace->mapping = MappedFile::openRead(path);
+        const MappedFile& file = *trace->mapping;
+        if (file.size() < sizeof(TraceFileHeader)) throw std::runtime_error(path + " is not a trace file (too short).");
+
+        TraceFileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) throw std::runtime_error(path + " is not a trace file.");
+        if (header.version != TRACE_VERSION) throw std::runtime_error(path + ": unsupported trace version " + std::to_string(header.version) + ".");
+        if (file.size() != traceFileSize(header.stations, header.records)) throw std::runtime_error(path + ": trace file is truncated.");
+
+        trace->offsets = reinterpret_cast<const uint64_t*>(file.data() + sizeof(TraceFileHeader));
+        trace->records = reinterpret_cast<const TraceRecord*>(trace->offsets + header.stations + 1);
+        trace->stationCount = static_cast<int>(header.stations);
+        trace->recordCount = static_cast<size_t>(header.records);
+        for (uint32_t s = 0; s < header.stations; ++s) {
+            if (trace->offsets[s] > trace->offsets[s + 1]) throw std::runtime_error(path + ": corrupt station offsets.");
+        }
+        if (trace->offsets[0] != 0 || trace->offsets[header.stations] != header.records) throw std::runtime_error(path + ": corrupt station offsets.");
+        return trace;
+    }
+
+    int stations() const { return stationCount; }
+    size_t size() const { return recordCount; }
+
+    // Arrivals of one station, empty if the trace has none
+    std::pair<const TraceRecord*, const TraceRecord*> station(int id) const {
+        if (id < 0 || id >= stationCount) return std::make_pair(nullptr, nullptr);
+        return std::make_pair(records + offsets[id], records + offsets[id + 1]);
+    }
+};
+
+// Summary of an import
+struct TraceImportSummary {
+    uint64_t records = 0;
+    uint32_t stations = 0;
+    double durationSeconds = 0;
+};
+
+// Split one CSV / TSV line into (timestamp, station, bytes); false for blank, comment or header lines
+inline bool parseTraceLine(const std::string& line, double& timestamp, std::string& station, uint32_t& bytes, size_t lineNumber) {
+    if (line.empty() || line[0] == '#' || line == "\r") return false;
+    size_t first = line.find_first_of(",\t");
+    size_t second = first == std::string::npos ? std::string::npos : line.find_first_of(",\t", first + 1);
+    if (second == std::string::npos) throw std::runtime_error("Trace CSV line " + std::to_string(lineNumber) + ": expected timestamp,station,bytes.");
+
+    char* endPtr = nullptr;
+    timestamp = std::strtod(line.c_str(), &endPtr);
+    if (endPtr != line.c_str() + first) {
+        if (lineNumber == 1) return false;  // Column header
+        throw std::runtime_error("Trace CSV line " + std::to_string(lineNumber) + ": bad timestamp.");
+    }
+    station = line.substr(first + 1, second - first - 1);
+    bytes = static_cast<uint32_t>(std::strtoul(line.c_str() + second + 1, nullptr, 10));
+    return true;
+}
+
+// Import a pcap-derived CSV (timestamp,station,bytes per line, e.g. `tshark -T fields -e frame.time_epoch
+// -e wlan.sa -e frame.len -E separator=,`) into a binary trace. Stations are numbered 0.. in order of first
+// appearance and timestamps are rebased to the earliest record.
+inline TraceImportSummary importCsvTrace(const std::string& csvPath, const std::string& tracePath) {
+    std::unordered_map<std::string, uint32_t> stationIds;
+    std::vector<uint64_t> counts;
+    double earliest = std::numeric_limits<double>::infinity(), latest = -std::numeric_limits<double>::infinity();
+    std::string line, station;
+    double timestamp;
+    uint32_t bytes;
+
+    // Pass 1: stations, records per station and the time span
+    {
+        std::ifstream in(csvPath);
+        if (!in) throw std::runtime_error("Could not open " + csvPath + ".");
+        size_t lineNumber = 0;
+        while (std::getline(in, line)) {
+            if (!parseTraceLine(line, timestamp, station, bytes, ++lineNumber)) continue;
+            auto inserted = stationIds.emplace(station, static_cast<uint32_t>(counts.size()));
+            if (inserted.second) counts.push_back(0);
+            counts[inserted.first->second]++;
+            earliest = std::min(earliest, timestamp);
+            latest = std::max(latest, timestamp);
+        }
+    }
+
+    TraceImportSummary summary;
+    summary.stations = static_cast<uint32_t>(counts.size());
+    for (uint64_t c : counts) summary.records += c;
+    summary.durationSeconds = summary.records ? latest - earliest : 0;
+
+    std::unique_ptr<MappedFile> out = MappedFile::create(tracePath, traceFileSize(summary.stations, summary.records));
+    TraceFileHeader header;
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.stations = summary.stations;
+    header.records = summary.records;
+    std::memcpy(out->data(), &header, sizeof(header));
+
+    uint64_t* offsets = reinterpret_cast<uint64_t*>(out->data() + sizeof(TraceFileHeader));
+    TraceRecord* records = reinterpret_cast<TraceRecord*>(offsets + summary.stations + 1);
+    offsets[0] = 0;
+    for (uint32_t s = 0; s < summary.stations; ++s) offsets[s + 1] = offsets[s] + counts[s];
+
+    // Pass 2: write every record into its station's slice of the mapping
+    std::vector<uint64_t> cursor(offsets, offsets + summary.stations);
+    {
+        std::ifstream in(csvPath);
+        size_t lineNumber = 0;
+        while (std::getline(in, line)) {
+            if (!parseTraceLine(line, timestamp, station, bytes, ++lineNumber)) continue;
+            auto known = stationIds.find(station);
+            if (known == stationIds.end() || cursor[known->second] == offsets[known->second + 1]) {
+                throw std::runtime_error(csvPath + " changed during import.");
+            }
+            uint32_t id = known->second;
+            TraceRecord& r = records[cursor[id]++];
+            r.timestamp = timestamp - earliest;
+            r.station = id;
+            r.bytes = bytes;
+        }
+    }
+
+    // Captures are nearly always time-ordered already; sort only the stations that are not
+    auto byTime = [](const TraceRecord& a, const TraceRecord& b) { return a.timestamp < b.timestamp; };
+    for (uint32_t s = 0; s < summary.stations; ++s) {
+        TraceRecord* begin = records + offsets[s];
+        TraceRecord* end = records + offsets[s + 1];
+        if (!std::is_sorted(begin, end, byTime)) std::stable_sort(begin, end, byTime);
+    }
+    return summary;
+}
+
+#endif
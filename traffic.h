@@ -0,0 +1,268 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rng.h"
+#include "trace.h"
+
+// Lazy per-user traffic generators.
+// A source only knows its next arrival: the simulation admits packets into a
+// user's queue once their arrival time has passed, so per-user memory is the
+// generator state plus the packets actually waiting, not the whole run's
+// traffic. Kinds: constant bit rate, Poisson, exponential on/off bursts (CBR
+// inside each on period) and replay of a station-grouped arrival trace.
+// A synthetic source carries --traffic-flows flows, and every packet is tagged
+// with its flow: CBR interleaves N flows of rate/N, Poisson colors each arrival
+// uniformly (N independent Poisson flows of rate/N), and each on/off burst
+// belongs to one flow. A replayed station is one flow. Tags come from their own
+// counter-based stream, so they never change the arrival times.
+
+enum class TrafficKind { Cbr, Poisson, OnOff, Trace };
+
+// TrafficSpec::packets default: the scenario's count (the whole trace for replay)
+const long long SCENARIO_PACKETS = -2;
+
+// Traffic model shared by every user of a simulation
+struct TrafficSpec {
+    TrafficKind kind = TrafficKind::Cbr;
+    double rate = 100.0;            // Packets/s: CBR and on-period spacing 1/rate, Poisson mean rate
+    double onMeanSeconds = 0.05;    // On/off: mean burst length
+    double offMeanSeconds = 0.05;   // On/off: mean silence between bursts
+    long long packets = SCENARIO_PACKETS;   // Packets per user, -1 = unbounded
+    double duration = std::numeric_limits<double>::infinity();  // No arrivals after start + duration
+    int flows = 4;                  // Flows per synthetic source
+    std::shared_ptr<const TraceArrivals> trace;                 // Replay source, shared by every simulation using the spec
+};
+
+// Traffic Source Class: next-arrival state of one user's generator, O(1) memory
+class TrafficSource {
+private:
+    TrafficKind kind;
+    int sequence;           // Id of the next packet
+    long long remaining;    // Packets left, -1 = unbounded
+    double start;
+    double stop;            // No arrivals after this time
+    double interval;        // CBR / on-period spacing
+    double meanGap;         // Poisson mean inter-arrival
+    double onMean;
+    double offMean;
+    double onUntil;         // End of the current on period
+    double next;            // Next arrival, infinity once exhausted
+    RngStream rng;
+    int flowCount;
+    int flow;               // Flow of the next packet
+    uint64_t flowKey;
+    const TraceRecord* cursor;
+    const TraceRecord* last;
+
+    int drawFlow() const { return flowCount > 1 ? static_cast<int>(counterDraw(flowKey, static_cast<uint64_t>(sequence)) % flowCount) : 0; }
+
+    void finishIfDone() {
+        if (remaining == 0 || next > stop) next = std::numeric_limits<double>::infinity();
+    }
+
+    // Arrival after `previous`, per kind
+    double following(double previous) {
+        switch (kind) {
+        case TrafficKind::Cbr:
+            return start + sequence * interval;  // Not accumulated, so spacing stays exact over long runs
+        case TrafficKind::Poisson:
+            return previous + rng.exponential(meanGap);
+        case TrafficKind::OnOff: {
+            double candidate = previous + interval;
+            if (candidate <= onUntil) return candidate;
+            double burstStart = onUntil + rng.exponential(offMean);
+            onUntil = burstStart + rng.exponential(onMean);
+            flow = drawFlow();
+            return burstStart;
+        }
+        case TrafficKind::Trace:
+            if (++cursor == last) return std::numeric_limits<double>::infinity();
+            return start + cursor->timestamp;
+        }
+        return std::numeric_limits<double>::infinity();
+    }
+
+public:
+    TrafficSource()
+        : kind(TrafficKind::Cbr), sequence(0), remaining(0), start(0), stop(0), interval(0), meanGap(0), onMean(0), offMean(0), onUntil(0),
+          next(std::numeric_limits<double>::infinity()), flowCount(1), flow(0), flowKey(0), cursor(nullptr), last(nullptr) {}
+
+    // Generator for one user: `packets` arrivals (-1 = unbounded) from `startTime`
+    TrafficSource(const TrafficSpec& spec, int userId, long long packets, double startTime, uint64_t seed)
+        : kind(spec.kind), sequence(0), remaining(packets), start(startTime), stop(startTime + spec.duration),
+          interval(1.0 / spec.rate), meanGap(1.0 / spec.rate), onMean(spec.onMeanSeconds), offMean(spec.offMeanSeconds), onUntil(startTime),
+          next(startTime), rng(seed, trafficStream(userId)), flowCount(spec.kind == TrafficKind::Trace ? 1 : spec.flows), flow(0),
+          flowKey(counterKey(seed, flowStream(userId))), cursor(nullptr), last(nullptr) {
+        if (flowCount < 1) throw std::invalid_argument("Traffic needs at least one flow.");
+        switch (kind) {
+        case TrafficKind::Cbr:
+            break;
+        case TrafficKind::Poisson:
+            next = startTime + rng.exponential(meanGap);
+            flow = drawFlow();
+            break;
+        case TrafficKind::OnOff:
+            onUntil = startTime + rng.exponential(onMean);
+            flow = drawFlow();
+            break;
+        case TrafficKind::Trace: {
+            if (!spec.trace) throw std::invalid_argument("Trace traffic needs a trace.");
+            std::pair<const TraceRecord*, const TraceRecord*> range = spec.trace->station(userId);
+            cursor = range.first;
+            last = range.second;
+            next = cursor == last ? std::numeric_limits<double>::infinity() : start + cursor->timestamp;
+            break;
+        }
+        }
+        finishIfDone();
+    }
+
+    bool exhausted() const { return next == std::numeric_limits<double>::infinity(); }
+    double peek() const { return next; }
+    int peekId() const { return sequence; }
+    int peekFlow() const { return flow; }
+
+    // Consume the next arrival and draw the one after it
+    void advance() {
+        if (remaining > 0) remaining--;
+        sequence++;
+        next = following(next);
+        if (kind == TrafficKind::Cbr) flow = sequence % flowCount;
+        else if (kind == TrafficKind::Poisson) flow = drawFlow();
+        finishIfDone();
+    }
+
+    // Give the generator fresh random streams from here on (forked what-if branches)
+    void reseed(uint64_t seed, int userId) {
+        rng = RngStream(seed, trafficStream(userId));
+        flowKey = counterKey(seed, flowStream(userId));
+    }
+
+    // Generator state; a trace cursor is stored as the number of the user's records left
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(kind);
+        out.put(sequence);
+        out.put(remaining);
+        out.put(start);
+        out.put(stop);
+        out.put(interval);
+        out.put(meanGap);
+        out.put(onMean);
+        out.put(offMean);
+        out.put(onUntil);
+        out.put(next);
+        rng.save(out);
+        out.put(flowCount);
+        out.put(flow);
+        out.put(flowKey);
+        out.put(static_cast<int64_t>(cursor ? last - cursor : 0));
+    }
+
+    // `spec` supplies the trace of a replayed source; it must be the trace the snapshot was taken with
+    template <typename Archive>
+    void load(Archive& in, const TrafficSpec& spec, int userId) {
+        in.get(kind);
+        in.get(sequence);
+        in.get(remaining);
+        in.get(start);
+        in.get(stop);
+        in.get(interval);
+        in.get(meanGap);
+        in.get(onMean);
+        in.get(offMean);
+        in.get(onUntil);
+        in.get(next);
+        rng.load(in);
+        in.get(flowCount);
+        in.get(flow);
+        in.get(flowKey);
+        int64_t left = in.template get<int64_t>();
+        cursor = last = nullptr;
+        if (kind != TrafficKind::Trace) return;
+        if (!spec.trace) throw std::runtime_error("Snapshot replays a trace: pass the same --trace file to resume it.");
+        std::pair<const TraceRecord*, const TraceRecord*> range = spec.trace->station(userId);
+        if (left < 0 || left > range.second - range.first) throw std::runtime_error("Snapshot trace position does not fit the trace.");
+        cursor = range.second - left;
+        last = range.second;
+    }
+};
+
+// A replayed trace drives one user per station (station N is user N), so a trace run has exactly that many users
+inline void checkTraceUsers(const TrafficSpec& spec, int userCount) {
+    if (spec.trace && spec.trace->stations() != userCount) {
+        throw std::invalid_argument("The trace has " + std::to_string(spec.trace->stations()) + " stations, but the run has " +
+                                    std::to_string(userCount) + " users.");
+    }
+}
+
+// User counts of a run: the trace's station count replaces the defaults, and given counts must match it
+inline std::vector<int> traceUserCounts(const TrafficSpec& spec, const std::vector<int>& userCounts, bool countsGiven) {
+    if (!spec.trace) return userCounts;
+    if (!countsGiven) return std::vector<int>(1, spec.trace->stations());
+    for (int users : userCounts) checkTraceUsers(spec, users);
+    return userCounts;
+}
+
+// Packets per user for a spec: its own count if set, else the scenario's (unbounded for a trace)
+inline long long trafficPackets(const TrafficSpec& spec, int scenarioPackets) {
+    if (spec.packets != SCENARIO_PACKETS) return spec.packets;
+    return spec.kind == TrafficKind::Trace ? -1 : scenarioPackets;
+}
+
+inline TrafficKind parseTrafficKind(const std::string& name) {
+    if (name == "cbr") return TrafficKind::Cbr;
+    if (name == "poisson") return TrafficKind::Poisson;
+    if (name == "onoff") return TrafficKind::OnOff;
+    throw std::invalid_argument("Unknown traffic model: " + name);
+}
+
+// True if any traffic option is given (a forked branch then switches to that traffic)
+inline bool hasTrafficArguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--traffic") == 0 || arg.compare(0, 8, "--trace=") == 0) return true;
+    }
+    return false;
+}
+
+// Parse "--traffic=cbr|poisson|onoff", "--traffic-rate=<pkt/s>", "--traffic-on=<s>", "--traffic-off=<s>",
+// "--traffic-packets=<N>", "--traffic-duration=<s>", "--traffic-flows=<N>" and "--trace=<file>" (replay);
+// defaults reproduce 10 ms CBR
+inline TrafficSpec parseTrafficArguments(int argc, char* argv[]) {
+    TrafficSpec spec;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string::size_type eq = arg.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = arg.substr(0, eq), value = arg.substr(eq + 1);
+        if (key == "--traffic") spec.kind = parseTrafficKind(value);
+        else if (key == "--traffic-rate") spec.rate = std::atof(value.c_str());
+        else if (key == "--traffic-on") spec.onMeanSeconds = std::atof(value.c_str());
+        else if (key == "--traffic-off") spec.offMeanSeconds = std::atof(value.c_str());
+        else if (key == "--traffic-packets") spec.packets = std::atoll(value.c_str());
+        else if (key == "--traffic-duration") spec.duration = std::atof(value.c_str());
+        else if (key == "--traffic-flows") {
+            char* end = nullptr;
+            long flows = std::strtol(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || flows < 1 || flows > 1 << 16) throw std::invalid_argument("Bad value \"" + value + "\" in --traffic-flows.");
+            spec.flows = static_cast<int>(flows);
+        }
+        else if (key == "--trace") {
+            spec.kind = TrafficKind::Trace;
+            spec.trace = TraceArrivals::open(value);
+        }
+    }
+    if (!(spec.rate > 0)) throw std::invalid_argument("Traffic rate must be positive.");
+    return spec;
+}
+
+#endif
@@ -0,0 +1,816 @@
+// Regression oracle and differential harness (make verify).
+//
+// Runs straightforward reference implementations next to the optimized
+// engines under the same seeds and scenarios, and reports correctness and
+// speedup per check in one table:
+//   exact         the fast engine must reproduce the reference's results (up
+//                 to floating-point summation order) from the same draws
+//   distribution  the engines draw differently; pooled latency must pass a
+//                 two-sample Kolmogorov-Smirnov test and mean throughput a
+//                 Welch test at --alpha
+//   identical     the same engine with a different thread count or kernel
+//                 must give bit-identical (or, for reordered sums, 1e-12)
+//                 results
+// Exits 1 if any check fails.
+//
+// The simulators are compiled into this translation unit (unity build), like
+// bench.cpp, so their internal entry points can be driven directly.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "wifi4.cpp"
+#include "wifi5.cpp"
+#include "part_2.cpp"
+
+#include "packet_metrics.h"
+#include "rng.h"
+#include "stats.h"
+#include "sweep.h"
+
+namespace {
+
+// Command-line options: [--users=N,N,...] [--seeds=N] [--packets=N] [--packets-per-user=N] [--alpha=A] [--threads=N]
+struct VerifyOptions {
+    std::vector<int> users = {1, 10, 100};
+    int seeds = 20;             // Replications per user count
+    int packets = 2000;         // WiFi 4 packets per replication
+    int packetsPerUser = 100;   // WiFi 5 / 6 Poisson packets per user and replication
+    double alpha = 1e-3;        // Significance level of each distribution check
+    unsigned threads = 4;       // Worker count compared against one thread
+};
+
+VerifyOptions parseVerifyArguments(int argc, char* argv[]) {
+    VerifyOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 8, "--users=") == 0) {
+            opts.users.clear();
+            std::stringstream list(arg.substr(8));
+            std::string item;
+            while (std::getline(list, item, ',')) opts.users.push_back(std::atoi(item.c_str()));
+        } else if (arg.compare(0, 8, "--seeds=") == 0) {
+            opts.seeds = std::atoi(arg.c_str() + 8);
+        } else if (arg.compare(0, 10, "--packets=") == 0) {
+            opts.packets = std::atoi(arg.c_str() + 10);
+        } else if (arg.compare(0, 19, "--packets-per-user=") == 0) {
+            opts.packetsPerUser = std::atoi(arg.c_str() + 19);
+        } else if (arg.compare(0, 8, "--alpha=") == 0) {
+            opts.alpha = std::atof(arg.c_str() + 8);
+        } else if (arg.compare(0, 10, "--threads=") == 0) {
+            opts.threads = static_cast<unsigned>(std::atoi(arg.c_str() + 10));
+        } else {
+            throw std::invalid_argument("Unknown option " + arg + ".");
+        }
+    }
+    if (opts.users.empty() || opts.seeds < 2 || opts.packets < 1 || opts.packetsPerUser < 1 || !(opts.alpha > 0 && opts.alpha < 1) ||
+        opts.threads < 2) {
+        throw std::invalid_argument("Need user counts, --seeds >= 2, --packets >= 1, --packets-per-user >= 1, 0 < --alpha < 1 and --threads >= 2.");
+    }
+    for (int u : opts.users) {
+        if (u < 1) throw std::invalid_argument("User counts must be positive.");
+    }
+    return opts;
+}
+
+// --- Reference implementations ---
+
+// The original WiFi 4 loop (the baseline simulateWiFi) on the simulator's RNG stream:
+// check the channel, back off, repeat; packets go back to back
+ReplicationResult referenceWifi4(int users, int packets, uint64_t seed) {
+    const double transmissionTime = wifi4::Wifi4Phy().airtime(wifi4::PACKET_BYTES);
+    RngStream rng(seed, SIMULATION_STREAM);
+    LatencyStats latencies;
+    double totalTime = 0.0;
+    for (int i = 0; i < packets; ++i) {
+        double latency = 0.0;
+        while (true) {
+            if (rng.bernoulli(1.0 / users)) {  // Probability the channel is free
+                latency += transmissionTime;
+                totalTime += transmissionTime;
+                latencies.record(latency);
+                break;
+            }
+            double backoff = rng.uniform(0, wifi4::MAX_BACKOFF);
+            latency += backoff;
+            totalTime += backoff;
+        }
+    }
+    ReplicationResult result;
+    result.throughputMbps = packets * (wifi4::PACKET_BYTES * 8) / totalTime / 1e6;
+    result.setLatency(latencies);
+    return result;
+}
+
+// Saturated legacy DCF ticking one idle slot at a time: every station's counter is decremented
+// each slot, and the stations whose counters reach zero transmit (several = collision)
+ReplicationResult referenceDcf(int users, int packets, uint64_t seed) {
+    const DcfTiming timing;
+    const EdcaParams& params = EDCA_PARAMS[static_cast<int>(AccessCategory::Legacy)];
+    const double transmissionTime = wifi4::Wifi4Phy().airtime(wifi4::PACKET_BYTES);
+    RngStream rng(seed, SIMULATION_STREAM);
+    std::vector<int> counter(users), cw(users, params.cwMin), retries(users, 0);
+    std::vector<double> headSince(users, 0.0);
+    for (int s = 0; s < users; ++s) counter[s] = static_cast<int>(rng.uniformInt(0, cw[s]));
+
+    LatencyStats latencies;
+    uint64_t drops = 0;
+    double now = 0.0;
+    int sent = 0;
+    std::vector<int> transmitters;
+    while (sent < packets) {
+        now += timing.sifs + params.aifsn * timing.slot;
+        while (true) {
+            transmitters.clear();
+            for (int s = 0; s < users; ++s) {
+                if (counter[s] == 0) transmitters.push_back(s);
+            }
+            if (!transmitters.empty()) break;
+            for (int s = 0; s < users; ++s) counter[s]--;
+            now += timing.slot;
+        }
+
+        if (transmitters.size() == 1) {
+            int s = transmitters.front();
+            now += timing.successDuration(transmissionTime);
+            latencies.record(now - headSince[s]);
+            headSince[s] = now;
+            sent++;
+            cw[s] = params.cwMin;
+            retries[s] = 0;
+            counter[s] = static_cast<int>(rng.uniformInt(0, cw[s]));
+        } else {
+            now += timing.collisionDuration(transmissionTime);
+            for (int s : transmitters) {
+                if (++retries[s] > timing.retryLimit) {
+                    drops++;
+                    headSince[s] = now;
+                    cw[s] = params.cwMin;
+                    retries[s] = 0;
+                } else {
+                    cw[s] = std::min(2 * (cw[s] + 1) - 1, params.cwMax);
+                }
+                counter[s] = static_cast<int>(rng.uniformInt(0, cw[s]));
+            }
+        }
+    }
+    ReplicationResult result;
+    result.throughputMbps = static_cast<double>(sent) * (wifi4::PACKET_BYTES * 8) / now / 1e6;
+    result.setLatency(latencies);
+    result.droppedPackets = static_cast<double>(drops);
+    return result;
+}
+
+// Pending events in a plain vector; the next one (earliest time, then scheduling order) is found by a
+// linear scan. The obvious calendar the heap-based EventEngine replaces, with the same tie-breaking.
+class ReferenceCalendar {
+public:
+    enum Kind { Arrival, FrameStart, TxStart, TxEnd, CsiReport };
+    struct Entry {
+        double time;
+        uint64_t seq;
+        Kind kind;
+        int user;
+        int resource;
+    };
+
+    void schedule(double time, Kind kind, int user = -1, int resource = -1) {
+        events.push_back(Entry{std::max(time, clock), nextSeq++, kind, user, resource});
+    }
+
+    bool empty() const { return events.empty(); }
+    double now() const { return clock; }
+
+    Entry pop() {
+        size_t next = 0;
+        for (size_t i = 1; i < events.size(); ++i) {
+            const Entry& e = events[i];
+            if (e.time < events[next].time || (e.time == events[next].time && e.seq < events[next].seq)) next = i;
+        }
+        Entry e = events[next];
+        events[next] = events.back();
+        events.pop_back();
+        clock = e.time;
+        return e;
+    }
+
+private:
+    std::vector<Entry> events;
+    uint64_t nextSeq = 0;
+    double clock = 0;
+};
+
+// Round-robin list of backlogged users as a deque plus membership flags
+struct ReferenceRoundRobin {
+    std::deque<int> order;
+    std::vector<char> queued;
+
+    explicit ReferenceRoundRobin(int users) : queued(users, 0) {}
+
+    void activate(int user) {
+        if (queued[user]) return;
+        queued[user] = 1;
+        order.push_back(user);
+    }
+
+    int pickNext() {
+        if (order.empty()) return -1;
+        int user = order.front();
+        order.pop_front();
+        queued[user] = 0;
+        return user;
+    }
+};
+
+// One user's Poisson arrivals, drawn up front from the traffic generator's stream, and its FIFO of arrival times
+struct ReferenceUser {
+    std::vector<double> arrivals;
+    size_t generated = 0;           // Arrivals moved into the queue (or dropped) so far
+    std::deque<double> queue;
+
+    ReferenceUser(int userId, int packets, double rate, uint64_t seed) {
+        RngStream rng(seed, trafficStream(userId));
+        double t = 0;
+        for (int i = 0; i < packets; ++i) arrivals.push_back(t += rng.exponential(1.0 / rate));
+    }
+
+    bool hasPackets() const { return !queue.empty() || generated < arrivals.size(); }
+    double nextArrival() const { return queue.empty() ? arrivals[generated] : queue.front(); }
+};
+
+// WiFi 5 MU-MIMO with the default options (round-robin, 4 streams, one packet per transmission): the scheduler
+// picks one backlogged user per stream, the AP sounds the channel, the group reports CSI one after another,
+// then each member sends on its own stream while its queued packets fit in the TXOP
+ReplicationResult referenceWifi5(int users, int packetsPerUser, uint64_t seed, double arrivalRate) {
+    typedef ReferenceCalendar::Kind Kind;
+    const wifi5::Wifi5Phy phy;
+    const int streams = wifi5::MAX_STREAMS;
+    const int packetBytes = Scenario().packetBytes;
+    const double soundingTime = phy.airtime(wifi5::SOUNDING_PACKET_BYTES);
+
+    std::vector<ReferenceUser> station;
+    std::vector<double> packetTime(users), csiTime(users);
+    for (int i = 0; i < users; ++i) {
+        station.emplace_back(i, packetsPerUser, arrivalRate, seed);
+        RngStream placement(seed, userStream(i));
+        double distance = static_cast<double>(placement.uniformInt(0, 1000));
+        double power = wifi5::MAX_POWER - (distance / wifi5::MAX_DISTANCE) * (wifi5::MAX_POWER - wifi5::MIN_POWER);
+        packetTime[i] = (packetBytes * 8) / wifi5::calculateTransmissionRate(phy, power);
+        csiTime[i] = (wifi5::CSI_REPORT_BYTES * 8) / wifi5::calculateTransmissionRate(phy, power);
+    }
+
+    ReferenceCalendar calendar;
+    ReferenceRoundRobin scheduler(users);
+    LatencyStats latencies;
+    enum class Phase { Idle, Sounding, CsiFeedback, Transmission } phase = Phase::Idle;
+    std::vector<int> group;
+    std::vector<char> streamBusy(streams, 0);
+    size_t csiReceived = 0;
+    int activeStreams = 0;
+    double txopStart = 0, txopEnd = 0;
+
+    auto backlogged = [&](int u) {
+        ReferenceUser& user = station[u];
+        while (user.generated < user.arrivals.size() && user.arrivals[user.generated] <= calendar.now()) {
+            user.queue.push_back(user.arrivals[user.generated++]);
+        }
+        return !user.queue.empty();
+    };
+    auto scheduleHeadArrival = [&](int u) {
+        if (station[u].hasPackets()) calendar.schedule(station[u].nextArrival(), Kind::Arrival, u);
+    };
+    auto startCycle = [&] {
+        if (phase != Phase::Idle) return;
+        group.clear();
+        while (group.size() < static_cast<size_t>(streams)) {
+            int u = scheduler.pickNext();
+            if (u == -1) break;
+            if (backlogged(u)) group.push_back(u);
+        }
+        if (group.empty()) return;
+        phase = Phase::Sounding;
+        calendar.schedule(calendar.now() + soundingTime, Kind::TxEnd);
+    };
+    auto continueOnStream = [&](int u, int stream) {
+        bool hasQueued = backlogged(u);
+        double now = calendar.now();
+        if (hasQueued && (now == txopStart || now + packetTime[u] <= txopEnd)) {
+            calendar.schedule(now, Kind::TxStart, u, stream);
+            return;
+        }
+        if (hasQueued) scheduler.activate(u);
+        streamBusy[stream] = 0;
+        if (--activeStreams == 0) {
+            phase = Phase::Idle;
+            startCycle();
+        }
+    };
+
+    for (int i = 0; i < users; ++i) scheduleHeadArrival(i);
+    while (!calendar.empty()) {
+        ReferenceCalendar::Entry ev = calendar.pop();
+        switch (ev.kind) {
+        case Kind::Arrival:
+            if (backlogged(ev.user)) scheduler.activate(ev.user);
+            startCycle();
+            break;
+        case Kind::CsiReport:
+            if (++csiReceived < group.size()) {
+                calendar.schedule(calendar.now() + csiTime[group[csiReceived]], Kind::CsiReport, group[csiReceived]);
+                break;
+            }
+            phase = Phase::Transmission;
+            txopStart = calendar.now();
+            txopEnd = txopStart + wifi5::TXOP_DURATION;
+            {
+                std::vector<std::pair<int, int>> assignments;
+                for (int u : group) {
+                    int stream = static_cast<int>(std::find(streamBusy.begin(), streamBusy.end(), 0) - streamBusy.begin());
+                    if (stream == streams) break;
+                    streamBusy[stream] = 1;
+                    assignments.emplace_back(u, stream);
+                }
+                activeStreams = static_cast<int>(assignments.size());
+                for (const std::pair<int, int>& a : assignments) continueOnStream(a.first, a.second);
+            }
+            break;
+        case Kind::TxStart:
+            calendar.schedule(calendar.now() + packetTime[ev.user], Kind::TxEnd, ev.user, ev.resource);
+            break;
+        case Kind::TxEnd:
+            if (ev.user == -1) {  // Sounding done: CSI reports in group order
+                phase = Phase::CsiFeedback;
+                csiReceived = 0;
+                calendar.schedule(calendar.now() + csiTime[group[0]], Kind::CsiReport, group[0]);
+                break;
+            }
+            latencies.record(calendar.now() - station[ev.user].queue.front());
+            station[ev.user].queue.pop_front();
+            scheduleHeadArrival(ev.user);
+            continueOnStream(ev.user, ev.resource);
+            break;
+        default:
+            break;
+        }
+    }
+
+    ReplicationResult result;
+    result.throughputMbps = static_cast<double>(latencies.count()) * (packetBytes * 8) / calendar.now() / 1e6;
+    result.setLatency(latencies);
+    return result;
+}
+
+// WiFi 6 OFDMA with the default options (round-robin, mixed RU layout, one packet per transmission): every
+// ALLOCATION_PERIOD the idle RUs go, widest first, to the next backlogged users, who send on them while their
+// packets fit in the frame. Queues hold queueSize packets (tail drop) and drop packets older than the timeout.
+ReplicationResult referenceWifi6(int users, int packetsPerUser, uint64_t seed, double arrivalRate) {
+    typedef ReferenceCalendar::Kind Kind;
+    const Scenario scenario;
+    const wifi6::Wifi6Phy phy;
+    const std::vector<double>& widths = wifi6::SUB_CHANNELS;
+    const size_t rus = widths.size();
+
+    std::vector<ReferenceUser> station;
+    for (int i = 0; i < users; ++i) station.emplace_back(i, packetsPerUser, arrivalRate, seed);
+    std::vector<double> packetTime(rus);
+    for (size_t r = 0; r < rus; ++r) packetTime[r] = phy.airtime(scenario.packetBytes, widths[r]);
+    std::vector<int> allocationOrder;
+    for (size_t r = 0; r < rus; ++r) allocationOrder.push_back(static_cast<int>(r));
+    std::stable_sort(allocationOrder.begin(), allocationOrder.end(), [&](int a, int b) { return widths[a] > widths[b]; });
+
+    ReferenceCalendar calendar;
+    ReferenceRoundRobin scheduler(users);
+    LatencyStats latencies;
+    uint64_t drops = 0;
+    std::vector<char> inService(users, 0), busy(rus, 0);
+    std::vector<int> owner(rus, -1), ownerFrame(rus, -1);
+    std::vector<double> busyUntil(rus, 0);
+    bool frameActive = false;
+    int frameIndex = 0;
+    double frameStart = 0, frameEnd = 0;
+
+    auto backlogged = [&](int u) {
+        ReferenceUser& user = station[u];
+        double now = calendar.now();
+        while (user.generated < user.arrivals.size() && user.arrivals[user.generated] <= now) {
+            if (user.queue.size() < static_cast<size_t>(scenario.queueSize)) user.queue.push_back(user.arrivals[user.generated]);
+            else drops++;
+            user.generated++;
+        }
+        while (!user.queue.empty() && now - user.queue.front() > scenario.timeoutSeconds) {
+            user.queue.pop_front();
+            drops++;
+        }
+        return !user.queue.empty();
+    };
+    auto scheduleHeadArrival = [&](int u) {
+        if (station[u].hasPackets()) calendar.schedule(station[u].nextArrival(), Kind::Arrival, u);
+    };
+    auto continueOnRu = [&](int r) {
+        busy[r] = 0;
+        if (owner[r] == -1 || ownerFrame[r] != frameIndex) return;
+        int u = owner[r];
+        bool hasQueued = backlogged(u);
+        double now = calendar.now();
+        if (hasQueued && (now == frameStart || now + packetTime[r] <= frameEnd)) {
+            busy[r] = 1;
+            busyUntil[r] = now + packetTime[r];
+            inService[u] = 1;
+            calendar.schedule(now, Kind::TxStart, u, r);
+            return;
+        }
+        if (hasQueued) scheduler.activate(u);
+        owner[r] = -1;
+    };
+    auto startFrame = [&] {
+        frameActive = false;
+        frameIndex++;
+        frameStart = calendar.now();
+        frameEnd = frameStart + wifi6::ALLOCATION_PERIOD;
+        for (int r : allocationOrder) {
+            owner[r] = -1;
+            if (busy[r]) continue;
+            int u;
+            while ((u = scheduler.pickNext()) != -1) {
+                if (inService[u]) continue;
+                if (backlogged(u)) {
+                    owner[r] = u;
+                    ownerFrame[r] = frameIndex;
+                    frameActive = true;
+                    break;
+                }
+            }
+            if (u == -1) break;
+        }
+        if (!frameActive) return;
+        calendar.schedule(frameEnd, Kind::FrameStart);
+        for (size_t r = 0; r < rus; ++r) {
+            if (owner[r] != -1) continueOnRu(static_cast<int>(r));
+        }
+    };
+
+    for (int i = 0; i < users; ++i) scheduleHeadArrival(i);
+    while (!calendar.empty()) {
+        ReferenceCalendar::Entry ev = calendar.pop();
+        switch (ev.kind) {
+        case Kind::Arrival:
+            if (!inService[ev.user] && backlogged(ev.user)) scheduler.activate(ev.user);
+            if (!frameActive) startFrame();
+            break;
+        case Kind::FrameStart:
+            startFrame();
+            break;
+        case Kind::TxStart:
+            calendar.schedule(busyUntil[ev.resource], Kind::TxEnd, ev.user, ev.resource);
+            break;
+        case Kind::TxEnd:
+            latencies.record(calendar.now() - station[ev.user].queue.front());
+            station[ev.user].queue.pop_front();
+            inService[ev.user] = 0;
+            scheduleHeadArrival(ev.user);
+            continueOnRu(ev.resource);
+            break;
+        default:
+            break;
+        }
+    }
+
+    ReplicationResult result;
+    result.throughputMbps = static_cast<double>(latencies.count()) * (scenario.packetBytes * 8) / calendar.now() / 1e6;
+    result.setLatency(latencies);
+    result.droppedPackets = static_cast<double>(drops);
+    return result;
+}
+
+// --- Statistics ---
+
+// Largest gap between the empirical CDFs of two histograms (same bucket layout, so the gap is taken at bucket edges)
+double ksDistance(const LatencyHistogram& a, const LatencyHistogram& b) {
+    const std::vector<uint64_t>& ca = a.bucketCounts();
+    const std::vector<uint64_t>& cb = b.bucketCounts();
+    double na = static_cast<double>(a.count()), nb = static_cast<double>(b.count());
+    uint64_t seenA = 0, seenB = 0;
+    double d = 0;
+    for (size_t i = 0; i < std::max(ca.size(), cb.size()); ++i) {
+        seenA += i < ca.size() ? ca[i] : 0;
+        seenB += i < cb.size() ? cb[i] : 0;
+        d = std::max(d, std::fabs(seenA / na - seenB / nb));
+    }
+    return d;
+}
+
+// Asymptotic two-sample KS p-value (Stephens' small-sample correction); binning makes it conservative
+double ksPValue(double d, uint64_t na, uint64_t nb) {
+    double n = static_cast<double>(na) * nb / (na + nb);
+    double lambda = (std::sqrt(n) + 0.12 + 0.11 / std::sqrt(n)) * d;
+    if (lambda < 0.2) return 1.0;
+    double p = 0, sign = 1;
+    for (int k = 1; k <= 100; ++k) {
+        double term = sign * std::exp(-2.0 * k * k * lambda * lambda);
+        p += term;
+        if (std::fabs(term) < 1e-12) break;
+        sign = -sign;
+    }
+    return std::min(1.0, std::max(0.0, 2.0 * p));
+}
+
+bool nearlyEqual(double a, double b, double tolerance) {
+    return std::fabs(a - b) <= tolerance * std::max(std::fabs(a), std::fabs(b));
+}
+
+// Two-sided Welch test on two samples' means; normal approximation of the t distribution.
+// Means equal up to rounding (deterministic metrics, e.g. a single user) always pass.
+double welchPValue(const std::vector<double>& a, const std::vector<double>& b) {
+    StreamingStats sa, sb;
+    for (double x : a) sa.record(x);
+    for (double x : b) sb.record(x);
+    double se = std::sqrt(sa.variance() / sa.count() + sb.variance() / sb.count());
+    double diff = std::fabs(sa.mean() - sb.mean());
+    if (nearlyEqual(sa.mean(), sb.mean(), 1e-9)) return 1.0;
+    if (se == 0) return 0.0;
+    return std::erfc(diff / se / std::sqrt(2.0));
+}
+
+// --- Report ---
+
+struct Check {
+    std::string name;
+    std::string kind;           // exact, distribution or identical
+    bool passed = true;
+    std::string detail;
+    double referenceSeconds = 0;
+    double fastSeconds = 0;
+
+    Check(const std::string& checkName, const std::string& checkKind) : name(checkName), kind(checkKind) {}
+};
+
+template <typename Run>
+double timed(Run run) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void printCheck(const Check& c) {
+    std::cout << std::left << std::setw(50) << c.name << std::setw(13) << c.kind << std::setw(6) << (c.passed ? "PASS" : "FAIL")
+              << std::right << std::fixed << std::setprecision(3) << std::setw(10) << c.referenceSeconds << std::setw(10)
+              << c.fastSeconds << std::setw(9) << std::setprecision(1)
+              << (c.fastSeconds > 0 ? c.referenceSeconds / c.fastSeconds : 0.0) << "x  " << c.detail << "\n";
+}
+
+// Same draws: counts equal, metrics equal up to summation order
+Check compareExact(const std::string& name, const std::vector<ReplicationResult>& ref, const std::vector<ReplicationResult>& fast) {
+    Check c{name, "exact"};
+    double worst = 0;
+    for (size_t i = 0; i < ref.size(); ++i) {
+        const ReplicationResult& r = ref[i];
+        const ReplicationResult& f = fast[i];
+        c.passed = c.passed && r.latency.count() == f.latency.count() && r.droppedPackets == f.droppedPackets &&
+                   nearlyEqual(r.throughputMbps, f.throughputMbps, 1e-9) && nearlyEqual(r.latency.mean(), f.latency.mean(), 1e-9) &&
+                   nearlyEqual(r.latency.max(), f.latency.max(), 1e-9);
+        worst = std::max(worst, std::fabs(r.throughputMbps - f.throughputMbps) / std::max(r.throughputMbps, 1e-300));
+    }
+    std::ostringstream detail;
+    detail << std::scientific << std::setprecision(1) << "max throughput rel. error " << worst;
+    c.detail = detail.str();
+    return c;
+}
+
+// Different draws: pooled latency distributions and per-replication throughput must agree
+Check compareDistribution(const std::string& name, const std::vector<ReplicationResult>& ref,
+                          const std::vector<ReplicationResult>& fast, double alpha) {
+    Check c{name, "distribution"};
+    LatencyStats pooledRef, pooledFast;
+    std::vector<double> tputRef, tputFast;
+    for (const ReplicationResult& r : ref) {
+        pooledRef.merge(r.latency);
+        tputRef.push_back(r.throughputMbps);
+    }
+    for (const ReplicationResult& f : fast) {
+        pooledFast.merge(f.latency);
+        tputFast.push_back(f.throughputMbps);
+    }
+    double d = ksDistance(pooledRef.getHistogram(), pooledFast.getHistogram());
+    double pLatency = ksPValue(d, pooledRef.count(), pooledFast.count());
+    double pThroughput = welchPValue(tputRef, tputFast);
+    c.passed = pLatency >= alpha && pThroughput >= alpha;
+    std::ostringstream detail;
+    detail << std::fixed << std::setprecision(4) << "KS D=" << d << " p=" << pLatency << ", Welch p=" << pThroughput
+           << std::setprecision(3) << ", mean latency " << pooledRef.mean() * 1e3 << " vs " << pooledFast.mean() * 1e3 << " ms";
+    c.detail = detail.str();
+    return c;
+}
+
+bool sameResult(const ReplicationResult& a, const ReplicationResult& b) {
+    return a.throughputMbps == b.throughputMbps && a.droppedPackets == b.droppedPackets && a.latency.count() == b.latency.count() &&
+           a.latency.mean() == b.latency.mean() && a.latency.max() == b.latency.max() &&
+           a.latency.getHistogram().bucketCounts() == b.latency.getHistogram().bucketCounts();
+}
+
+// --- Checks ---
+
+void checkWifi4(const VerifyOptions& opts, std::vector<Check>& checks) {
+    for (int users : opts.users) {
+        std::string suffix = " (" + std::to_string(users) + " users)";
+        std::vector<ReplicationResult> reference(opts.seeds), event(opts.seeds), geometric(opts.seeds), batch(opts.seeds);
+        double referenceSeconds = timed([&] {
+            for (int s = 0; s < opts.seeds; ++s) reference[s] = referenceWifi4(users, opts.packets, replicationSeed(1, s));
+        });
+
+        double eventSeconds = timed([&] {
+            for (int s = 0; s < opts.seeds; ++s) {
+                event[s] = wifi4::simulateWiFi(users, opts.packets, 0.0, replicationSeed(1, s), wifi4::BackoffMode::Reference);
+            }
+        });
+        Check c = compareExact("wifi4 loop vs event engine, reference" + suffix, reference, event);
+        c.referenceSeconds = referenceSeconds;
+        c.fastSeconds = eventSeconds;
+        checks.push_back(c);
+
+        double geometricSeconds = timed([&] {
+            for (int s = 0; s < opts.seeds; ++s) geometric[s] = wifi4::simulateWiFi(users, opts.packets, 0.0, replicationSeed(1, s));
+        });
+        c = compareDistribution("wifi4 loop vs geometric backoff" + suffix, reference, geometric, opts.alpha);
+        c.referenceSeconds = referenceSeconds;
+        c.fastSeconds = geometricSeconds;
+        checks.push_back(c);
+
+        double batchSeconds = timed([&] {
+            for (int s = 0; s < opts.seeds; ++s) batch[s] = wifi4::simulateWiFiBatch(users, opts.packets, replicationSeed(1, s));
+        });
+        c = compareDistribution("wifi4 loop vs batch backend" + suffix, reference, batch, opts.alpha);
+        c.referenceSeconds = referenceSeconds;
+        c.fastSeconds = batchSeconds;
+        checks.push_back(c);
+    }
+}
+
+void checkDcf(const VerifyOptions& opts, std::vector<Check>& checks) {
+    const double transmissionTime = wifi4::Wifi4Phy().airtime(wifi4::PACKET_BYTES);
+    for (int users : opts.users) {
+        std::vector<ReplicationResult> reference(opts.seeds), fast(opts.seeds);
+        double referenceSeconds = timed([&] {
+            for (int s = 0; s < opts.seeds; ++s) reference[s] = referenceDcf(users, opts.packets, replicationSeed(1, s));
+        });
+        double fastSeconds = timed([&] {
+            for (int s = 0; s < opts.seeds; ++s) fast[s] = wifi4::simulateDcf(users, opts.packets, 0.0, replicationSeed(1, s), transmissionTime);
+        });
+        Check c = compareExact("DCF slot ticking vs slot skipping (" + std::to_string(users) + " users)", reference, fast);
+        c.referenceSeconds = referenceSeconds;
+        c.fastSeconds = fastSeconds;
+        checks.push_back(c);
+    }
+}
+
+// Poisson traffic at the generator's default rate, so the seeds matter and the queues build up and drain
+TrafficSpec poissonTraffic() {
+    TrafficSpec spec;
+    spec.kind = TrafficKind::Poisson;
+    return spec;
+}
+
+void checkWifi5(const VerifyOptions& opts, std::vector<Check>& checks) {
+    const TrafficSpec traffic = poissonTraffic();
+    for (int users : opts.users) {
+        std::vector<ReplicationResult> reference(opts.seeds), fast(opts.seeds);
+        double referenceSeconds = timed([&] {
+            for (int s = 0; s < opts.seeds; ++s) reference[s] = referenceWifi5(users, opts.packetsPerUser, replicationSeed(1, s), traffic.rate);
+        });
+        double fastSeconds = timed([&] {
+            for (int s = 0; s < opts.seeds; ++s) {
+                wifi5::WiFiSimulation<wifi5::User<wifi5::Packet>, wifi5::FrequencyChannel> simulation(users, replicationSeed(1, s));
+                simulation.setTraffic(traffic);
+                simulation.runSimulation(users, opts.packetsPerUser);
+                fast[s] = simulation.getResult();
+            }
+        });
+        Check c = compareExact("wifi5 loop vs MU-MIMO event engine (" + std::to_string(users) + " users)", reference, fast);
+        c.referenceSeconds = referenceSeconds;
+        c.fastSeconds = fastSeconds;
+        checks.push_back(c);
+    }
+}
+
+void checkWifi6(const VerifyOptions& opts, std::vector<Check>& checks) {
+    const TrafficSpec traffic = poissonTraffic();
+    for (int users : opts.users) {
+        std::vector<ReplicationResult> reference(opts.seeds), fast(opts.seeds);
+        double referenceSeconds = timed([&] {
+            for (int s = 0; s < opts.seeds; ++s) reference[s] = referenceWifi6(users, opts.packetsPerUser, replicationSeed(1, s), traffic.rate);
+        });
+        double fastSeconds = timed([&] {
+            for (int s = 0; s < opts.seeds; ++s) {
+                wifi6::WiFiSimulation<wifi6::User<wifi6::Packet>, wifi6::SubChannel> simulation(users);
+                simulation.setTraffic(traffic, replicationSeed(1, s));
+                simulation.runSimulation(opts.packetsPerUser);
+                fast[s] = simulation.getResult();
+            }
+        });
+        Check c = compareExact("wifi6 loop vs OFDMA event engine (" + std::to_string(users) + " users)", reference, fast);
+        c.referenceSeconds = referenceSeconds;
+        c.fastSeconds = fastSeconds;
+        checks.push_back(c);
+    }
+}
+
+// The batch backend's summary must not depend on its thread count
+void checkBatchThreads(const VerifyOptions& opts, std::vector<Check>& checks) {
+    const int packets = 1 << 20;
+    int users = opts.users.back();
+    ReplicationResult single, parallel;
+    Check c{"wifi4 batch, 1 vs " + std::to_string(opts.threads) + " threads (" + std::to_string(users) + " users)", "identical"};
+    c.referenceSeconds = timed([&] { single = wifi4::simulateWiFiBatch(users, packets, 7, wifi4::Wifi4Phy(), 1); });
+    c.fastSeconds = timed([&] { parallel = wifi4::simulateWiFiBatch(users, packets, 7, wifi4::Wifi4Phy(), opts.threads); });
+    c.passed = sameResult(single, parallel);
+    c.detail = std::to_string(packets) + " packets";
+    checks.push_back(c);
+}
+
+// Every SIMD metrics kernel this CPU runs against the scalar one on the same buffer
+void checkPacketMetrics(std::vector<Check>& checks) {
+    const size_t n = 1000003;
+    RngStream rng(11, SIMULATION_STREAM);
+    std::vector<double> arrival(n), end(n);
+    for (size_t i = 0; i < n; ++i) {
+        arrival[i] = rng.uniform(0, 10.0);
+        end[i] = arrival[i] + (rng.bernoulli(0.01) ? -rng.uniform(0, 1e-3) : rng.exponential(2e-3));  // A few rejected packets
+    }
+    std::vector<uint64_t> buckets(n), scalarBins, bins;
+    PacketMetrics scalar;
+    double scalarSeconds = timed([&] { scalar = computePacketMetrics(arrival.data(), end.data(), n, buckets.data(), scalarBins, MetricsKernel::Scalar); });
+
+    MetricsKernel best = detectMetricsKernel();
+    for (MetricsKernel kernel : {MetricsKernel::Avx2, MetricsKernel::Avx512}) {
+        if (kernel > best) continue;
+        PacketMetrics m;
+        Check c{std::string("packet metrics scalar vs ") + metricsKernelName(kernel), "identical"};
+        c.referenceSeconds = scalarSeconds;
+        c.fastSeconds = timed([&] { m = computePacketMetrics(arrival.data(), end.data(), n, buckets.data(), bins, kernel); });
+        c.passed = m.delivered == scalar.delivered && m.rejected == scalar.rejected && bins == scalarBins && m.min == scalar.min &&
+                   m.max == scalar.max && nearlyEqual(m.sum, scalar.sum, 1e-12) && nearlyEqual(m.m2, scalar.m2, 1e-12);
+        c.detail = std::to_string(n) + " packets, sums to 1e-12 (lane order)";
+        checks.push_back(c);
+    }
+}
+
+// Sweeps of the WiFi 5 and WiFi 6 simulators must not depend on the sweep's thread count
+void checkSweepThreads(const VerifyOptions& opts, std::vector<Check>& checks) {
+    std::vector<Replication> runs = buildSweep("wifi5", opts.users, 4, 1);
+    auto wifi5Run = [](const Replication& r) { return wifi5::simulate(r.userCount, 20, r.seed); };
+    auto wifi6Run = [](const Replication& r) { return wifi6::simulate(r.userCount, 20); };
+    for (int standard : {5, 6}) {
+        std::vector<ReplicationResult> single, parallel;
+        Check c{"wifi" + std::to_string(standard) + " sweep, 1 vs " + std::to_string(opts.threads) + " threads", "identical"};
+        c.referenceSeconds = timed([&] {
+            SweepRunner runner(1);
+            single = standard == 5 ? runner.run(runs, wifi5Run) : runner.run(runs, wifi6Run);
+        });
+        c.fastSeconds = timed([&] {
+            SweepRunner runner(opts.threads);
+            parallel = standard == 5 ? runner.run(runs, wifi5Run) : runner.run(runs, wifi6Run);
+        });
+        for (size_t i = 0; i < runs.size(); ++i) c.passed = c.passed && sameResult(single[i], parallel[i]);
+        c.detail = std::to_string(runs.size()) + " replications";
+        checks.push_back(c);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    VerifyOptions opts;
+    try {
+        opts = parseVerifyArguments(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n"
+                  << "Usage: wifisim_verify [--users=N,N,...] [--seeds=N] [--packets=N] [--packets-per-user=N] [--alpha=A] [--threads=N]\n";
+        return 2;
+    }
+
+    std::vector<Check> checks;
+    checkWifi4(opts, checks);
+    checkDcf(opts, checks);
+    checkWifi5(opts, checks);
+    checkWifi6(opts, checks);
+    checkBatchThreads(opts, checks);
+    checkPacketMetrics(checks);
+    checkSweepThreads(opts, checks);
+
+    std::cout << std::left << std::setw(50) << "check" << std::setw(13) << "kind" << std::setw(6) << "result" << std::right
+              << std::setw(10) << "ref s" << std::setw(10) << "fast s" << std::setw(10) << "speedup" << "  detail\n";
+    int failed = 0;
+    for (const Check& c : checks) {
+        printCheck(c);
+        if (!c.passed) failed++;
+    }
+    std::cout << checks.size() - failed << "/" << checks.size() << " checks passed\n";
+    return failed ? 1 : 0;
+}
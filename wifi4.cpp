@@ -1,78 +1,322 @@
 #include <iostream>
 #include <vector>
-#include <random>
 #include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+#include "contention_batch.h"
+#include "dcf.h"
+#include "event_engine.h"
+#include "instrumentation.h"
+#include "phy_profile.h"
+#include "results.h"
+#include "rng.h"
+#include "scenario.h"
+#include "snapshot.h"
+#include "steady_state.h"
+#include "sweep.h"
+#include "wifisim.h"
+
+namespace wifi4 {
 
 // Constants
-const double BANDWIDTH = 20e6;  // 20 MHz
-const int MODULATION = 8;       // 256-QAM (8 bits per symbol)
-const double CODING_RATE = 5.0 / 6.0;
-const double DATA_RATE = BANDWIDTH * MODULATION * CODING_RATE;  // bits per second
-const int PACKET_SIZE = 8192;   // 1 KB in bits
-const double TRANSMISSION_TIME = PACKET_SIZE / DATA_RATE;  // seconds
+typedef FixedPhy<9, 20> Wifi4Phy;   // 20 MHz, 256-QAM (8 bits per symbol), coding rate 5/6
+const int PACKET_BYTES = 1024;  // Default packet size (1 KB); --packet-size overrides it
 const double MAX_BACKOFF = 10e-6;  // 10 µs
+const uint64_t EXACT_BACKOFF_SUM_LIMIT = 16;  // Above this many failures the summed backoff uses the normal limit
+
+// Engine that runs the geometric contention model
+enum class Backend {
+    Event,  // Event calendar, one packet after another
+    Batch   // Every packet drawn independently, in vectorized blocks over a thread pool (contention_batch.h)
+};
+
+// Backoff sampling mode
+enum class BackoffMode {
+    Reference,  // One Bernoulli channel check and one backoff draw per try
+    Geometric,  // Failed tries ~ Geometric(1/users), summed backoff drawn in one step
+    Dcf         // Saturated stations under 802.11 DCF: per-station windows, collisions, ACKs (dcf.h)
+};
+
+// Sum of `failures` independent U(0, MAX_BACKOFF) backoffs (Irwin-Hall).
+// Small counts are summed exactly; larger counts use the normal limit
+// N(k*M/2, k*M^2/12), clamped to the support [0, k*M].
+double sampleTotalBackoff(RngStream& rng, uint64_t failures) {
+    if (failures <= EXACT_BACKOFF_SUM_LIMIT) {
+        double sum = 0.0;
+        for (uint64_t i = 0; i < failures; ++i) sum += rng.uniform(0, MAX_BACKOFF);
+        return sum;
+    }
+    double k = static_cast<double>(failures);
+    double sum = k * MAX_BACKOFF / 2.0 + rng.normal() * MAX_BACKOFF * std::sqrt(k / 12.0);
+    return std::min(std::max(sum, 0.0), k * MAX_BACKOFF);
+}
+
+// `users` saturated stations contend under DCF until `packets` frames are delivered.
+// Latency is each frame's access delay: from reaching the head of its station's queue to its ACK.
+inline ReplicationResult simulateDcf(int users, int packets, double paceRatio, uint64_t seed, double transmissionTime,
+                                     const SteadyStateOptions& steadyState = SteadyStateOptions(), PacketLog* packetLog = nullptr,
+                                     int packetBytes = PACKET_BYTES) {
+    DcfMedium medium(users, seed);
+    SteadyStateMonitor steady(steadyState);
+    double measurementStart = 0;
+    int measuredFrom = 0;           // Frames delivered during the discarded warm-up
+    uint64_t dropsBefore = 0;
+    const DcfTiming& timing = medium.getTiming();
+    LatencyStats latencies;
+    std::vector<double> headSince(users, 0.0);
+    std::vector<int> transmitters;
+
+    EventEngine engine;
+    RealTimePacer pacer(paceRatio);
+    engine.setPacer(&pacer);
+    for (int i = 0; i < users; ++i) medium.activate(i);
+    int sent = 0;
+    if (packets > 0) engine.scheduleIn(medium.nextAttempt(transmitters), EventType::TxStart);
+
+    engine.run([&](const Event& ev) {
+        switch (ev.type) {
+        case EventType::TxStart:
+            // Contention resolved by slot skipping; the medium is busy for one exchange
+            engine.scheduleIn(transmitters.size() == 1 ? timing.successDuration(transmissionTime) : timing.collisionDuration(transmissionTime),
+                              EventType::TxEnd);
+            break;
+        case EventType::TxEnd:
+            if (transmitters.size() == 1) {
+                int station = transmitters.front();
+                double latency = ev.time - headSince[station];
+                latencies.record(latency);
+                if (packetLog) packetLog->record(station, headSince[station], ev.time);
+                headSince[station] = ev.time;
+                sent++;
+                medium.onSuccess(station, true);
+                switch (steady.record(ev.time, latency)) {
+                case SteadyStateMonitor::Transition::WarmedUp:
+                    latencies = LatencyStats();
+                    measurementStart = ev.time;
+                    measuredFrom = sent;
+                    dropsBefore = medium.drops();
+                    break;
+                case SteadyStateMonitor::Transition::Converged:
+                    engine.stop();
+                    return;
+                default:
+                    break;
+                }
+            } else {
+                for (int station : transmitters) {
+                    if (medium.onCollision(station)) headSince[station] = ev.time;
+                }
+            }
+            if (sent < packets) engine.scheduleIn(medium.nextAttempt(transmitters), EventType::TxStart);
+            break;
+        default:
+            break;
+        }
+    });
+
+    ReplicationResult result;
+    result.throughputMbps = static_cast<double>(sent - measuredFrom) * (packetBytes * 8) / (engine.now() - measurementStart) / 1e6;
+    result.setLatency(latencies);
+    result.droppedPackets = static_cast<double>(medium.drops() - dropsBefore);
+    result.simulatedEvents = engine.processedEvents();
+    steady.annotate(result, engine.now());
+    return result;
+}
 
 // Function to simulate the transmission for a given number of users and packets
-void simulateWiFi(int users, int packets) {
-    std::vector<double> latencies;
+template <typename PhyType = Wifi4Phy>
+ReplicationResult simulateWiFi(int users, int packets, double paceRatio = 0.0, uint64_t seed = 1,
+                               BackoffMode mode = BackoffMode::Geometric, const PhyType& phy = PhyType(),
+                               const SteadyStateOptions& steadyState = SteadyStateOptions(), PacketLog* packetLog = nullptr,
+                               int packetBytes = PACKET_BYTES) {
+    WIFISIM_PHASE(Transmission);  // Arrivals are generated inside the event loop, so the whole run is transmission
+    const double transmissionTime = phy.airtime(packetBytes);  // Once per run; a FixedPhy rate is a compile-time constant
+    if (mode == BackoffMode::Dcf) return simulateDcf(users, packets, paceRatio, seed, transmissionTime, steadyState, packetLog, packetBytes);
+    LatencyStats latencies;
     double total_time = 0.0;
+    SteadyStateMonitor steady(steadyState);
+    double measurementStart = 0;
+    int measuredFrom = 0;   // Packets delivered during the discarded warm-up
 
-    // Random number generator for backoff time
-    std::default_random_engine generator;
-    std::uniform_real_distribution<double> distribution(0, MAX_BACKOFF);
+    // Random number stream for channel sensing and backoff time
+    RngStream rng(seed, SIMULATION_STREAM);
 
-    for (int i = 0; i < packets; ++i) {
-        double latency = 0.0;
-        while (true) {
-            // Simulate channel checking and backoff
-            if ((rand() / (double)RAND_MAX) < (1.0 / users)) {  // Probability the channel is free
-                latency += TRANSMISSION_TIME;
-                total_time += TRANSMISSION_TIME;
-                latencies.push_back(latency);
+    // Packets are offered back to back: packet i+1 arrives when packet i finishes
+    EventEngine engine;
+    RealTimePacer pacer(paceRatio);  // Unpaced unless a ratio was requested
+    engine.setPacer(&pacer);
+    double arrival = 0.0;
+    int sent = 0;
+    if (packets > 0) engine.schedule(0.0, EventType::Arrival, 0, 0, 0);
+
+    engine.run([&](const Event& ev) {
+        switch (ev.type) {
+        case EventType::Arrival:
+            arrival = ev.time;
+            if (mode == BackoffMode::Geometric) {
+                // Jump straight past every failed try to the successful channel check
+                uint64_t failures = rng.geometric(1.0 / users);
+                WIFISIM_COUNT(BackoffIterations, failures);
+                double backoff = sampleTotalBackoff(rng, failures);
+                engine.scheduleIn(backoff, EventType::TxStart, 0, 0, ev.packetId);
                 break;
+            }
+            [[fallthrough]];
+        case EventType::BackoffExpiry:
+            // Simulate channel checking and backoff
+            if (rng.bernoulli(1.0 / users)) {  // Probability the channel is free
+                engine.schedule(ev.time, EventType::TxStart, 0, 0, ev.packetId);
             } else {
-                double backoff = distribution(generator);
-                latency += backoff;
-                total_time += backoff;
+                WIFISIM_COUNT(BackoffIterations, 1);
+                engine.scheduleIn(rng.uniform(0, MAX_BACKOFF), EventType::BackoffExpiry, 0, 0, ev.packetId);
+            }
+            break;
+        case EventType::TxStart:
+            engine.scheduleIn(transmissionTime, EventType::TxEnd, 0, 0, ev.packetId);
+            break;
+        case EventType::TxEnd:
+            latencies.record(ev.time - arrival);
+            if (packetLog) packetLog->record(0, arrival, ev.time);
+            ++sent;
+            switch (steady.record(ev.time, ev.time - arrival)) {
+            case SteadyStateMonitor::Transition::WarmedUp:
+                latencies = LatencyStats();
+                measurementStart = ev.time;
+                measuredFrom = sent;
+                break;
+            case SteadyStateMonitor::Transition::Converged:
+                engine.stop();
+                return;
+            default:
+                break;
             }
+            if (sent < packets) engine.schedule(ev.time, EventType::Arrival, 0, 0, sent);
+            break;
+        default:
+            break;
         }
-    }
+    });
+    total_time = engine.now();
 
     // Metrics calculation
-    double throughput = (packets * PACKET_SIZE) / total_time;  // bits per second
-    double avg_latency = 0.0;
-    double max_latency = 0.0;
-
-    for (double l : latencies) {
-        avg_latency += l;
-        if (l > max_latency) {
-            max_latency = l;
-        }
-    }
-    avg_latency /= latencies.size();
+    double throughput = (static_cast<double>(sent - measuredFrom) * (packetBytes * 8)) / (total_time - measurementStart);  // bits per second
+
+    ReplicationResult result;
+    result.throughputMbps = throughput / 1e6;
+    result.setLatency(latencies);
+    result.simulatedEvents = engine.processedEvents();
+    steady.annotate(result, total_time);
+    return result;
+}
+
+// Geometric contention for all packets at once; the same model as BackoffMode::Geometric, drawn from a
+// counter-based stream, so the results match simulateWiFi in distribution rather than packet by packet
+template <typename PhyType = Wifi4Phy>
+ReplicationResult simulateWiFiBatch(int users, int packets, uint64_t seed = 1, const PhyType& phy = PhyType(),
+                                    unsigned threads = 1, int packetBytes = PACKET_BYTES) {
+    WIFISIM_PHASE(Transmission);
+    ContentionModel model{users, MAX_BACKOFF, EXACT_BACKOFF_SUM_LIMIT, phy.airtime(packetBytes)};
+    uint64_t failures = 0;
+    LatencyStats latencies = simulateContentionBatch(model, static_cast<uint64_t>(std::max(packets, 0)), seed, threads, &failures);
+    WIFISIM_COUNT(BackoffIterations, failures);
 
-    // Print results
+    // Back to back: the run lasts as long as the latencies add up to
+    ReplicationResult result;
+    result.throughputMbps = latencies.count() ? static_cast<double>(latencies.count()) * (packetBytes * 8) / latencies.sum() / 1e6 : 0.0;
+    result.setLatency(latencies);
+    return result;
+}
+
+// Function to print the results of one run
+void displayResults(int users, const ReplicationResult& result) {
+    WIFISIM_PHASE(ResultDisplay);
     std::cout << "Number of users: " << users << "\n";
-    std::cout << "Throughput: " << std::fixed << std::setprecision(2) << (throughput / 1e6) << " Mbps\n";
-    std::cout << "Average Latency: " << std::fixed << std::setprecision(6) << (avg_latency * 1e3) << " ms\n";
-    std::cout << "Maximum Latency: " << std::fixed << std::setprecision(6) << (max_latency * 1e3) << " ms\n";
+    std::cout << "Throughput: " << std::fixed << std::setprecision(2) << result.throughputMbps << " Mbps\n";
+    std::cout << "Average Latency: " << std::fixed << std::setprecision(6) << result.avgLatencyMs << " ms\n";
+    std::cout << "Maximum Latency: " << std::fixed << std::setprecision(6) << result.maxLatencyMs << " ms\n";
+    std::cout << "99th Percentile Latency: " << std::fixed << std::setprecision(6) << result.p99LatencyMs << " ms\n";
+    printSteadyState(std::cout, result);
 }
 
-int main() {
-    int packets = 1000;  // Number of packets to simulate
+ReplicationResult simulate(int users, int packets, uint64_t seed) {
+    return simulateWiFi(users, packets, 0.0, seed);
+}
 
-    int user[3] = {1,10,100};
+ReplicationResult simulateBatch(int users, int packets, uint64_t seed, unsigned threads) {
+    return simulateWiFiBatch(users, packets, seed, Wifi4Phy(), threads);
+}
 
-    for(int i = 0 ;i < 3; i++)
-    {
-        simulateWiFi(user[i], packets);
-        std::cout<<std::endl;
+// Command-line entry point (wifisim --standard=4)
+int run(int argc, char* argv[]) {
+    try {
+        const Scenario scenario = parseScenarioArguments(argc, argv);  // Opt-in: --users=N,N,.. --packets=N --packet-size=B
+        int packets = scenario.packets;  // Number of packets to simulate
+        double paceRatio = parsePaceArgument(argc, argv);  // Opt-in: --pace=1.0 for real time
+        SweepOptions sweep = parseSweepArguments(argc, argv); // Opt-in: --sweep --seeds=N --threads=N
+        int mcs = parseMcsArgument(argc, argv);             // Opt-in: --mcs=N overrides the fixed profile
+        SteadyStateOptions steadyState = parseSteadyStateArguments(argc, argv);  // Opt-in: --steady-state, --ci-precision=F
+        BackoffMode mode = BackoffMode::Geometric;
+        Backend backend = Backend::Event;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--backoff=reference") mode = BackoffMode::Reference;
+            else if (arg == "--backoff=dcf") mode = BackoffMode::Dcf;
+            else if (arg == "--backend=batch") backend = Backend::Batch;
+            else if (arg == "--backend=event") backend = Backend::Event;
+        }
+        if (backend == Backend::Batch && (mode != BackoffMode::Geometric || steadyState.enabled || paceRatio > 0 ||
+                                          parseResultsArguments(argc, argv).packets)) {
+            std::cerr << "--backend=batch runs the geometric backoff model only, without --steady-state, --pace or --results-packets" << std::endl;
+            return 2;
+        }
+
+        CheckpointOptions checkpoints = parseCheckpointArguments(argc, argv);
+        if (!checkpoints.checkpoint.empty() || !checkpoints.resume.empty() || !checkpoints.fork.empty()) {
+            std::cerr << "--checkpoint, --resume and --fork are supported by --standard=5 and --standard=6 only" << std::endl;
+            return 2;
+        }
+
+        const std::vector<int>& user = scenario.userCounts;
+
+        ResultsWriter results(parseResultsArguments(argc, argv));  // Opt-in: --results=FILE [--results-packets]
+        withPhy<Wifi4Phy>(mcs, [&](auto phy) {
+            if (sweep.enabled) {
+                std::vector<Replication> runs = buildSweep("wifi4", user, sweep.seeds, 1);
+                SweepRunner runner(sweep.threads);
+                std::vector<ReplicationResult> runResults = runner.run(runs, [&](const Replication& r) {
+                    return results.record(r, [&](PacketLog* log) {
+                        if (backend == Backend::Batch) return simulateWiFiBatch(r.userCount, packets, r.seed, phy, 1, scenario.packetBytes);
+                        return simulateWiFi(r.userCount, packets, 0.0, r.seed, mode, phy, steadyState, log, scenario.packetBytes);
+                    });
+                });
+                SweepRunner::printSummary(SweepRunner::aggregate(runs, runResults), std::cout);
+                return;
+            }
+
+            for(size_t i = 0 ;i < user.size(); i++)
+            {
+                displayResults(user[i], results.record(Replication{"wifi4", user[i], 1, {}}, [&](PacketLog* log) {
+                    if (backend == Backend::Batch) return simulateWiFiBatch(user[i], packets, 1, phy, sweep.threads, scenario.packetBytes);
+                    return simulateWiFi(user[i], packets, paceRatio, 1, mode, phy, steadyState, log, scenario.packetBytes);
+                }));
+                std::cout<<std::endl;
+            }
+        });
+        results.close();
+    } catch (const std::exception& ex) {
+        std::cerr << "Exception caught in main: " << ex.what() << std::endl;
+        return 1;
     }
 
     return 0;
 }
 
 
+}  // namespace wifi4
+
+
 /*
 
 1. For 1 User and 1 AP
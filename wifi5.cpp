@@ -1,66 +1,126 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
-#include <queue>
-#include <random>
 #include <algorithm>
 #include <stdexcept> // For exception handling
-#include <chrono>
-#include <thread>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <cstdlib>
+#include <utility>
+
+#include "aggregation.h"
+#include "arena.h"
+#include "event_engine.h"
+#include "instrumentation.h"
+#include "link_adaptation.h"
+#include "packet_metrics.h"
+#include "packet_ring.h"
+#include "phy_profile.h"
+#include "queue_discipline.h"
+#include "results.h"
+#include "rng.h"
+#include "scenario.h"
+#include "scheduler.h"
+#include "stats.h"
+#include "steady_state.h"
+#include "snapshot.h"
+#include "sweep.h"
+#include "traffic.h"
+#include "wifisim.h"
+
+namespace wifi5 {
 
 using namespace std;
 
 // Constants
-const double BANDWIDTH_MHZ = 20.0;      // Total bandwidth in MHz
-const double MODULATION_BITS = 8;       // 256-QAM -> log2(256) = 8 bits/symbol
-const double CODING_RATE = 5.0 / 6.0;   // Coding rate
-const int PACKET_SIZE_BYTES = 1024;     // Packet size in bytes
-const int MAX_BACKOFF = 10;             // Maximum backoff time in ms
-const int MAX_STREAMS = 4;              // Maximum simultaneous streams (MU-MIMO)
+typedef FixedPhy<9, 20> Wifi5Phy;       // 20 MHz, 256-QAM (8 bits/symbol), coding rate 5/6
+const int SOUNDING_PACKET_BYTES = 1024; // Broadcast sounding packet in bytes
+const int CSI_REPORT_BYTES = 200;       // Channel state information per user in bytes
+const double TXOP_DURATION = 0.015;     // Default parallel communication window (15 ms), --txop=S
+const int MAX_STREAMS = 4;              // Default simultaneous streams (MU-MIMO)
+const int MAX_SUPPORTED_STREAMS = 64;   // Upper bound of the stream bitmask (8x8, 16-stream APs fit)
 const int MAX_SIMULATION_TIME = 5000;   // Max simulation time in ms
 const double MIN_POWER = 0.5;           // Min transmission power
 const double MAX_POWER = 1.5;           // Max transmission power
 const double MAX_DISTANCE = 1000.0;     // Max distance for users (meters)
+const int VHT_MAX_MCS = 9;              // 802.11ac tops out at 256-QAM 5/6
 
-// Function to calculate data rate per stream
-double calculateTransmissionRate(int numStreams, double powerFactor) {
-    double adjustedBandwidth = BANDWIDTH_MHZ / numStreams;
-    return adjustedBandwidth * 1e6 * MODULATION_BITS * CODING_RATE * powerFactor; // bits per second
+// Function to calculate data rate per stream: every spatial stream spans the whole channel, scaled by the power factor of its user
+template <typename PhyType>
+double calculateTransmissionRate(const PhyType& phy, double powerFactor) {
+    return phy.dataRate(phy.getProfile().channelWidthMhz) * powerFactor; // bits per second
 }
 
-// Packet Class
+// Packet Class: view of one slot in a user's structure-of-arrays packet ring
 class Packet {
 public:
-    int packetID;
-    double arrivalTimestamp;
-    double transmissionStart;
-    double transmissionEnd;
+    int& packetID;
+    double& arrivalTimestamp;
+    double& transmissionStart;
+    double& transmissionEnd;
 
-    Packet(int id, double arrivalTime)
-        : packetID(id), arrivalTimestamp(arrivalTime), transmissionStart(0), transmissionEnd(0) {}
+    Packet(PacketRing& ring, size_t slot)
+        : packetID(ring.idAt(slot)), arrivalTimestamp(ring.arrivalAt(slot)), transmissionStart(ring.startAt(slot)), transmissionEnd(ring.endAt(slot)) {}
 };
 
-// Frequency Channel Class
+// Frequency Channel Class: word-sized free-stream bitmask with per-stream busy-until times
 class FrequencyChannel {
 private:
-    vector<bool> occupiedStreams;
+    uint64_t freeMask;                          // Bit i set = stream i free
+    int streamCount;
+    double busyUntil[MAX_SUPPORTED_STREAMS];    // Release time of each busy stream
 
 public:
-    FrequencyChannel(int streamCount) : occupiedStreams(streamCount, false) {}
+    FrequencyChannel(int count) : freeMask(0), streamCount(count) {
+        if (count < 1 || count > MAX_SUPPORTED_STREAMS) {
+            throw invalid_argument("Stream count must be between 1 and " + to_string(MAX_SUPPORTED_STREAMS) + ".");
+        }
+        freeMask = count == 64 ? ~0ULL : (1ULL << count) - 1;
+        fill(busyUntil, busyUntil + MAX_SUPPORTED_STREAMS, 0.0);
+    }
 
+    // Lowest free stream in O(1) via count-trailing-zeros, -1 if all are busy
     int findAvailableStream() const {
-        for (size_t i = 0; i < occupiedStreams.size(); ++i) {
-            if (!occupiedStreams[i]) return i;
-        }
-        return -1;
+        return freeMask ? __builtin_ctzll(freeMask) : -1;
     }
 
-    void reserveStream(int streamIdx) {
-        occupiedStreams[streamIdx] = true;
+    void reserveStream(int streamIdx, double until = numeric_limits<double>::infinity()) {
+        freeMask &= ~(1ULL << streamIdx);
+        busyUntil[streamIdx] = until;
     }
 
     void releaseStream(int streamIdx) {
-        occupiedStreams[streamIdx] = false;
+        freeMask |= 1ULL << streamIdx;
+        busyUntil[streamIdx] = 0;
+    }
+
+    // Earliest time a busy stream frees up (infinity if no stream is busy)
+    double earliestRelease() const {
+        uint64_t busy = ~freeMask & (streamCount == 64 ? ~0ULL : (1ULL << streamCount) - 1);
+        double earliest = numeric_limits<double>::infinity();
+        while (busy) {
+            int idx = __builtin_ctzll(busy);
+            earliest = min(earliest, busyUntil[idx]);
+            busy &= busy - 1;
+        }
+        return earliest;
+    }
+
+    int getStreamCount() const { return streamCount; }
+    int availableStreams() const { return __builtin_popcountll(freeMask); }
+
+    template <typename Archive>
+    void save(Archive& out) const {
+        out.put(freeMask);
+        for (int i = 0; i < streamCount; ++i) out.put(busyUntil[i]);
+    }
+
+    template <typename Archive>
+    void load(Archive& in) {
+        in.get(freeMask);
+        for (int i = 0; i < streamCount; ++i) in.get(busyUntil[i]);
     }
 };
 
@@ -70,18 +130,56 @@ class User {
 public:
     int userID;
     double distanceFromAP;  // Distance from the Access Point (meters)
-    queue<PacketType> packetQueue;
-
-    User(int id, double distance) : userID(id), distanceFromAP(distance) {}
+    double meanSnrDb;       // Path-loss SNR at the AP (link adaptation only)
+    int mcs;                // Current MCS, -1 = distance power factor model
+    PacketRing packetQueue; // Arrived, unsent packets only; grows with the backlog (with --aqm: those taken for transmission)
+    TrafficSource traffic;  // Next arrival, generated lazily
+    QueueDiscipline qdisc;  // --aqm queue in front of packetQueue, off by default
+    QueueStats queueStats;  // Deliveries and drops of the current run
+
+    User(int id, double distance, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : userID(id), distanceFromAP(distance), meanSnrDb(0), mcs(-1), packetQueue(0, resource), qdisc(resource) {}
+
+    void setTraffic(const TrafficSource& source) {
+        packetQueue.clear();
+        qdisc.clear();
+        queueStats = QueueStats();
+        traffic = source;
+    }
 
-    void generatePackets(int packetCount, double currentTimestamp) {
-        for (int i = 0; i < packetCount; ++i) {
-            packetQueue.emplace(i, currentTimestamp + i * 0.01);
+    // Move every arrival up to `now` from the generator into the queue, or the discipline; returns the packets dropped
+    int admitArrivals(double now) {
+        int dropped = 0;
+        while (!traffic.exhausted() && traffic.peek() <= now) {
+            if (qdisc.enabled()) {
+                dropped += qdisc.enqueue(traffic.peekFlow(), traffic.peekId(), traffic.peek());
+            } else {
+                if (packetQueue.full()) packetQueue.reserve(packetQueue.capacity() ? packetQueue.capacity() * 2 : 16);
+                packetQueue.push(traffic.peekId(), traffic.peek());
+            }
+            traffic.advance();
         }
+        queueStats.overflowDrops += dropped;
+        WIFISIM_COUNT(Drops, dropped);
+        return dropped;
     }
 
-    bool hasPackets() const { return !packetQueue.empty(); }
-    Packet& nextPacket() { return packetQueue.front(); }
+    // With --aqm: take packets from the discipline until `n` are ready to send; returns the packets CoDel dropped
+    int stagePackets(double now, size_t n) {
+        if (!qdisc.enabled() || packetQueue.size() >= n) return 0;
+        int dropped = qdisc.dequeueInto(now, packetQueue, n - packetQueue.size());
+        queueStats.aqmDrops += dropped;
+        WIFISIM_COUNT(Drops, dropped);
+        return dropped;
+    }
+
+    // Queued or still to arrive; the head is the oldest queued packet, else the generator's next arrival
+    bool hasPackets() const { return !packetQueue.empty() || !qdisc.empty() || !traffic.exhausted(); }
+    double nextArrival() const {
+        if (!packetQueue.empty()) return packetQueue.frontArrival();
+        return qdisc.empty() ? traffic.peek() : qdisc.anyArrival();
+    }
+    PacketType nextPacket() { return PacketType(packetQueue, packetQueue.frontSlot()); }
     void removePacket() { packetQueue.pop(); }
 
     double getDistance() const { return distanceFromAP; }
@@ -101,163 +199,675 @@ private:
 public:
     AccessPoint(ChannelType& channel) : frequencyChannel(channel) {}
 
-    bool sendPacket(Packet& pkt, double& currentTimestamp, double transmissionRate, int streamIdx) {
+    // Reserve the stream and stamp the packet; the stream stays busy until finishPacket()
+    bool sendPacket(Packet& pkt, double currentTimestamp, double timeToTransmit, int streamIdx) {
         try {
             if (streamIdx == -1) {
                 throw runtime_error("No available streams for transmission.");
             }
 
-            frequencyChannel.reserveStream(streamIdx);
             pkt.transmissionStart = currentTimestamp;
-            double timeToTransmit = (PACKET_SIZE_BYTES * 8) / transmissionRate; // seconds
             pkt.transmissionEnd = currentTimestamp + timeToTransmit;
+            frequencyChannel.reserveStream(streamIdx, pkt.transmissionEnd);
 
             if (pkt.transmissionEnd > MAX_SIMULATION_TIME) {
                 frequencyChannel.releaseStream(streamIdx);
                 return false; // Packet dropped
             }
 
-            this_thread::sleep_for(chrono::milliseconds(1)); // Simulate transmission delay
-            currentTimestamp = pkt.transmissionEnd;
-            frequencyChannel.releaseStream(streamIdx);
             return true; // Packet successfully transmitted
         } catch (const exception& ex) {
             cerr << "Transmission error: " << ex.what() << endl;
             return false; // Packet dropped due to an error
         }
     }
+
+    void finishPacket(int streamIdx) {
+        frequencyChannel.releaseStream(streamIdx);
+    }
 };
 
 // WiFi Simulation Class
-template <typename UserType, typename ChannelType>
+template <typename UserType, typename ChannelType, typename SchedulerType = RoundRobinScheduler, typename PhyType = Wifi5Phy>
 class WiFiSimulation {
 private:
-    vector<UserType*> users;
+    SimulationArena arena;          // Owns users, their queues and the AP; declared first so it is released last
+    std::pmr::vector<UserType*> users;
     AccessPoint<ChannelType>* ap;
     ChannelType channel;
+    SchedulerType scheduler;        // Picks the users of each MU-MIMO group
+    PhyType phy;
+    int packetBytes;                // Data packet size, from the scenario
+    uint64_t seed;                  // Placement seed (user distances)
+    uint64_t trafficSeed;           // Arrival and fading seed; a forked branch replaces it
+    TrafficSpec trafficSpec;        // Arrival model of every user, 10 ms CBR by default
     double simulationTime;
+    uint64_t simulatedEvents;
     int transmittedPackets;
     int droppedPackets;
-    double totalLatency;
-    double maxPacketLatency;
+    LatencyStats latencyStats;  // Per-packet latency, O(1) memory
+    CompletedPackets completed; // Finished packets, reduced into latencyStats in SIMD batches
+    RealTimePacer pacer;    // Disabled unless setPacing() is called
+    EventEngine engine;     // Member so a run can stop, be snapshotted and continue
+    SteadyStateMonitor steady;  // Off unless setSteadyState() enables it
+    double measurementStart;    // End of the discarded warm-up, 0 without one
+    PacketLog* packetLog;       // Per-packet records for --results-packets, null otherwise
+
+    // MU-MIMO cycle: broadcast sounding -> sequential CSI feedback -> parallel TXOP
+    enum class Phase { Idle, Sounding, CsiFeedback, Transmission };
+    Phase phase;
+    vector<int> group;      // Users served in the current TXOP, one per stream
+    size_t csiReceived;     // CSI reports collected in the current cycle
+    double txopDuration;    // Parallel window of each cycle, TXOP_DURATION unless setTxopDuration() changes it
+    double txopStart;
+    double txopEnd;
+    int activeStreams;      // Streams still transmitting in the current TXOP
+    Aggregator aggregator;  // A-MPDU / A-MSDU bursts, off unless setAggregation() enables it
+    vector<int> burstFrames;    // Packets in the burst on each stream
+    QueueOptions queueOptions;  // Per-user queue discipline and report, the built-in queue by default
+
+    // Per-user rates: fixed by the distance power factor, or picked from the airtime table by link adaptation.
+    // Every stream spans the whole channel; the AP splits its power over the streams, so a stream's SNR is
+    // the user's SNR less streamPowerSplitDb, while a CSI report is sent at the user's full SNR.
+    enum { WHOLE_CHANNEL = 0 };                     // Airtime table width
+    enum { DATA_PACKET = 0, CSI_REPORT = 1 };       // Airtime table packet sizes
+    LinkOptions link;
+    AirtimeTable airtimes;
+    double streamPowerSplitDb;      // 10 log10(streams)
+    vector<double> packetAirtimes;  // Current airtime of one data packet on one stream
+    vector<double> csiAirtimes;     // Current airtime of one CSI report over the whole channel
+    RngStream fadingRng;
+
+    // Serve the user at the MCS its SNR supports on one stream (data) and on the whole link (CSI): table lookups, no rate math
+    void applyLink(int userIdx, double snrDb) {
+        int mcs = selectMcs(snrDb - streamPowerSplitDb, VHT_MAX_MCS);
+        users[userIdx]->mcs = mcs;
+        packetAirtimes[userIdx] = airtimes.lookup(mcs, WHOLE_CHANNEL, 1, DATA_PACKET);
+        csiAirtimes[userIdx] = airtimes.lookup(selectMcs(snrDb, VHT_MAX_MCS), WHOLE_CHANNEL, 1, CSI_REPORT);
+        scheduler.setRate(userIdx, (packetBytes * 8) / packetAirtimes[userIdx]);
+    }
+
+    // Fresh fading draw on CSI feedback, then re-select the MCS
+    void adaptLink(int userIdx) {
+        applyLink(userIdx, users[userIdx]->meanSnrDb + link.budget.fadingSigmaDb * fadingRng.normal());
+    }
 
-    double randomBackoffTime() {
-        random_device rd;
-        mt19937 gen(rd());
-        uniform_int_distribution<> dist(1, MAX_BACKOFF);
-        return dist(gen) / 1000.0; // Convert ms to seconds
+    // Rate of the best-placed user, which sizes the scheduler's per-TXOP quantum
+    double bestStreamRate() const {
+        return link.enabled ? (packetBytes * 8) / airtimes.lookup(VHT_MAX_MCS, WHOLE_CHANNEL, 1, DATA_PACKET)
+                            : calculateTransmissionRate(phy, MAX_POWER);
     }
 
 public:
-    WiFiSimulation(int userCount) : channel(MAX_STREAMS), simulationTime(0), transmittedPackets(0), droppedPackets(0), totalLatency(0), maxPacketLatency(0) {
+    WiFiSimulation(int userCount, uint64_t seed = 1, int streamCount = MAX_STREAMS, const PhyType& phyProfile = PhyType(), const LinkOptions& linkOptions = LinkOptions(),
+                   const Scenario& scenario = Scenario())
+        : arena(userCount * (sizeof(UserType) + 64) + 1024), users(arena.resource()), channel(streamCount), scheduler(userCount), phy(phyProfile), packetBytes(scenario.packetBytes), seed(seed), trafficSeed(seed), simulationTime(0), simulatedEvents(0), transmittedPackets(0), droppedPackets(0), completed(latencyStats), measurementStart(0), packetLog(nullptr), phase(Phase::Idle), csiReceived(0), txopDuration(TXOP_DURATION), txopStart(0), txopEnd(0), activeStreams(0),
+          burstFrames(streamCount, 0), link(linkOptions), streamPowerSplitDb(10 * log10(static_cast<double>(streamCount))), packetAirtimes(userCount), csiAirtimes(userCount), fadingRng(seed, SIMULATION_STREAM) {
+        users.reserve(userCount);
+        group.reserve(streamCount);
+        double width = phy.getProfile().channelWidthMhz;
+        if (link.enabled) airtimes = AirtimeTable(phy.getProfile(), {width}, 1, {packetBytes, CSI_REPORT_BYTES});
         for (int i = 0; i < userCount; ++i) {
-            double distance = static_cast<double>(rand() % 1001);  // Random distance for each user
-            users.push_back(new UserType(i, distance));
+            RngStream userRng(seed, userStream(i));
+            double distance = static_cast<double>(userRng.uniformInt(0, 1000));  // Random distance for each user
+            UserType* user = arena.create<UserType>(i, distance, arena.resource());
+            users.push_back(user);
+            if (link.enabled) {
+                user->meanSnrDb = link.budget.snrDb(distance, width);
+                applyLink(i, user->meanSnrDb);
+            } else {
+                double rate = calculateTransmissionRate(phy, user->calculatePowerFactor());
+                packetAirtimes[i] = (packetBytes * 8) / rate;
+                csiAirtimes[i] = (CSI_REPORT_BYTES * 8) / rate;
+                scheduler.setRate(i, rate);
+            }
         }
-        ap = new AccessPoint<ChannelType>(channel);
+        ap = arena.create<AccessPoint<ChannelType>>(channel);
+        setTxopDuration(TXOP_DURATION);
     }
 
-    ~WiFiSimulation() {
-        for (auto user : users) delete user;
-        delete ap;
+    WiFiSimulation(const WiFiSimulation&) = delete;
+    WiFiSimulation& operator=(const WiFiSimulation&) = delete;
+
+    // Pace simulated time against the wall clock (ratio = sim seconds per wall second, 0 = unpaced)
+    void setPacing(double ratio) { pacer = RealTimePacer(ratio); }
+
+    void setTraffic(const TrafficSpec& spec) { trafficSpec = spec; }
+
+    // Length of the parallel window; the scheduler's quantum is one window at the best rate
+    void setTxopDuration(double seconds) {
+        if (!(seconds > 0)) throw invalid_argument("TXOP duration must be positive.");
+        txopDuration = seconds;
+        scheduler.setQuantum(static_cast<int>(txopDuration * bestStreamRate() / 8));  // One TXOP per turn
     }
 
-    void runSimulation(int userCount, int packetsPerUser) {
-        double currentTime = 0;
+    // Opt in to warm-up truncation and the confidence-interval stopping rule
+    void setSteadyState(const SteadyStateOptions& options) { steady = SteadyStateMonitor(options); }
 
-        for (auto& user : users) {
-            user->generatePackets(packetsPerUser, currentTime);
+    // Record every delivered packet into `log` (null = off)
+    void setPacketLog(PacketLog* log) { packetLog = log; }
+
+    // Send queued packets as A-MPDU / A-MSDU bursts with VHT framing
+    void setAggregation(const AggregationOptions& options) { aggregator = Aggregator(options, VHT_AGGREGATION); }
+
+    // Put a queue discipline (tail-drop, CoDel, FQ-CoDel) in front of every user's queue
+    void setQueueDiscipline(const QueueOptions& options) {
+        queueOptions = options;
+        for (UserType* user : users) user->qdisc.configure(options, packetBytes);
+    }
+
+    // Schedule an Arrival for the user's head-of-line packet
+    void scheduleHeadArrival(EventEngine& engine, int userIdx) {
+        if (users[userIdx]->hasPackets()) {
+            engine.schedule(users[userIdx]->nextArrival(), EventType::Arrival, userIdx);
         }
+    }
 
-        try {
-            while (true) {
-                bool allQueuesEmpty = true;
-
-                for (auto& user : users) {
-                    if (user->hasPackets()) {
-                        allQueuesEmpty = false;
-                        Packet& packet = user->nextPacket();
-
-                        int streamIdx = -1;
-                        while ((streamIdx = channel.findAvailableStream()) == -1) {
-                            currentTime += randomBackoffTime();
-                            if (currentTime > MAX_SIMULATION_TIME) {
-                                throw runtime_error("Simulation exceeded maximum allowed time.");
-                            }
-                        }
-
-                        double powerFactor = user->calculatePowerFactor();  // Get power factor based on distance
-                        bool transmissionSuccess = ap->sendPacket(packet, currentTime, calculateTransmissionRate(MAX_STREAMS, powerFactor), streamIdx);
-                        if (transmissionSuccess) {
-                            double latency = packet.transmissionEnd - packet.arrivalTimestamp;
-
-                            if (latency > 0) {
-                                totalLatency += latency;
-                                maxPacketLatency = max(maxPacketLatency, latency);
-                                transmittedPackets++;
-                            }
-                        } else {
-                            droppedPackets++; // Increment dropped packet counter
-                        }
-
-                        user->removePacket();
-                    }
-                }
+    bool isBacklogged(UserType* user, double now) {
+        droppedPackets += user->admitArrivals(now);
+        return !user->packetQueue.empty() || !user->qdisc.empty();
+    }
 
-                if (allQueuesEmpty || currentTime > MAX_SIMULATION_TIME) break; // Stop if all queues empty or time exceeds
-            }
-        } catch (const exception& ex) {
-            cerr << "Simulation error: " << ex.what() << endl;
+    double packetAirtime(int userIdx) const { return packetAirtimes[userIdx]; }
+
+    // Medium time of a burst of `frames` packets; a single bare packet without aggregation
+    double burstAirtime(int userIdx, int frames) const {
+        if (!aggregator.enabled()) return packetAirtime(userIdx);
+        return aggregator.exchangeDuration(frames, packetBytes, (packetBytes * 8) / packetAirtime(userIdx));
+    }
+
+    // Packets the user may send next on its stream: what is queued and fits in the rest of the TXOP
+    int burstLimit(int userIdx, double now) const {
+        bool first = now == txopStart;
+        if (!aggregator.enabled()) return first || now + packetAirtime(userIdx) <= txopEnd ? 1 : 0;
+        int queued = static_cast<int>(users[userIdx]->packetQueue.size() + users[userIdx]->qdisc.size());
+        return aggregator.burstSize(queued, packetBytes, (packetBytes * 8) / packetAirtime(userIdx), txopEnd - now, first);
+    }
+
+    // Let the scheduler pick the next group (one backlogged user per stream) and broadcast the sounding packet
+    void startCycle(EventEngine& engine) {
+        if (phase != Phase::Idle) return;
+        WIFISIM_PHASE(Scheduling);
+
+        group.clear();
+        size_t groupSize = static_cast<size_t>(channel.getStreamCount());
+        while (group.size() < groupSize) {
+            int userIdx = scheduler.pickNext();
+            if (userIdx == -1) break;
+            if (isBacklogged(users[userIdx], engine.now())) group.push_back(userIdx);
         }
+        if (group.empty()) return;  // The next Arrival restarts the cycle
 
-        simulationTime = currentTime;
+        phase = Phase::Sounding;
+        double soundingTime = phy.airtime(SOUNDING_PACKET_BYTES);  // Whole channel
+        engine.scheduleIn(soundingTime, EventType::TxEnd);  // No user / stream: broadcast sounding
     }
 
-    void displayResults(int userCount) {
-        try {
-            if (transmittedPackets == 0) {
-                throw runtime_error("No packets transmitted. Simulation may have failed.");
+    // Group members report channel state one after another over the whole channel
+    void scheduleCsiReport(EventEngine& engine) {
+        int userIdx = group[csiReceived];
+        engine.scheduleIn(csiAirtimes[userIdx], EventType::CsiReport, userIdx);
+    }
+
+    // Parallel phase: every group member holds its own stream until the TXOP ends
+    void startTransmission(EventEngine& engine) {
+        phase = Phase::Transmission;
+        txopStart = engine.now();
+        txopEnd = txopStart + txopDuration;
+
+        vector<pair<int, int>> assignments;  // (user, stream)
+        for (int userIdx : group) {
+            int streamIdx = channel.findAvailableStream();
+            if (streamIdx == -1) {
+                WIFISIM_COUNT(StreamAllocationFailures, 1);
+                break;
             }
+            channel.reserveStream(streamIdx, txopEnd);
+            assignments.emplace_back(userIdx, streamIdx);
+        }
+        activeStreams = static_cast<int>(assignments.size());
+        for (auto& a : assignments) continueOnStream(engine, a.first, a.second);
+    }
 
-            double throughput = (transmittedPackets * PACKET_SIZE_BYTES * 8) / simulationTime; // in bps
-            double avgLatency = transmittedPackets > 0 ? totalLatency / transmittedPackets : 0;
+    // Send the user's next packet (or burst) on its stream if it has arrived and fits in the TXOP, else give the stream back
+    void continueOnStream(EventEngine& engine, int userIdx, int streamIdx) {
+        UserType* user = users[userIdx];
+        bool backlogged = isBacklogged(user, engine.now());
+        int limit = backlogged ? burstLimit(userIdx, engine.now()) : 0;
+        if (limit > 0 && user->qdisc.enabled()) {  // Dequeue through the discipline, which may drop some or all of them
+            droppedPackets += user->stagePackets(engine.now(), static_cast<size_t>(limit));
+            limit = min(limit, static_cast<int>(user->packetQueue.size()));
+            backlogged = limit > 0;
+        }
+        int frames = 0;
+        while (frames < limit && scheduler.consume(userIdx, packetBytes)) frames++;
+        if (frames > 0) {
+            burstFrames[streamIdx] = frames;
+            engine.schedule(engine.now(), EventType::TxStart, userIdx, streamIdx);
+            return;
+        }
+
+        // Turn over: back in line if still backlogged
+        if (backlogged) scheduler.activate(userIdx);
+        else if (!user->hasPackets()) scheduler.onIdle(userIdx);
+        ap->finishPacket(streamIdx);
+        if (--activeStreams == 0) {
+            phase = Phase::Idle;
+            startCycle(engine);
+        }
+    }
 
-            cout << fixed << setprecision(2);
-            cout << "Simulation Results for " << userCount << " Users:\n";
-            if (userCount == 1) {
-                cout << "Throughput: " << (throughput / 1e6) / userCount + 1 << " Mbps\n";
-            } else if (userCount == 10) {
-                cout << "Throughput: " << (throughput / 1e6) / userCount + 3 << " Mbps\n";
+    // Discard the warm-up once it is detected, stop once the confidence target is met
+    void trackSteadyState(EventEngine& engine, double latency) {
+        switch (steady.record(engine.now(), latency)) {
+        case SteadyStateMonitor::Transition::WarmedUp:
+            completed.discard();
+            latencyStats = LatencyStats();
+            droppedPackets = 0;
+            for (UserType* user : users) user->queueStats = QueueStats();
+            measurementStart = engine.now();
+            break;
+        case SteadyStateMonitor::Transition::Converged:
+            engine.stop();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void handleEvent(EventEngine& engine, const Event& ev) {
+        switch (ev.type) {
+        case EventType::Arrival:
+            if (isBacklogged(users[ev.userId], engine.now())) scheduler.activate(ev.userId);
+            startCycle(engine);
+            break;
+        case EventType::CsiReport:
+            if (link.enabled && link.budget.fadingSigmaDb > 0) adaptLink(ev.userId);
+            if (++csiReceived < group.size()) scheduleCsiReport(engine);
+            else startTransmission(engine);
+            break;
+        case EventType::TxStart: {
+            UserType* user = users[ev.userId];
+            int frames = burstFrames[ev.resource];
+            Packet packet = user->nextPacket();
+            if (ap->sendPacket(packet, engine.now(), burstAirtime(ev.userId, frames), ev.resource)) {
+                for (int i = 1; i < frames; ++i) {  // The rest of the burst shares the head packet's PPDU
+                    size_t slot = user->packetQueue.slotAt(i);
+                    user->packetQueue.startAt(slot) = packet.transmissionStart;
+                    user->packetQueue.endAt(slot) = packet.transmissionEnd;
+                }
+                engine.schedule(packet.transmissionEnd, EventType::TxEnd, ev.userId, ev.resource);
             } else {
-                cout << "Throughput: " << (throughput / 1e6) / userCount + 2 << " Mbps\n";
+                droppedPackets += frames; // Increment dropped packet counter
+                user->queueStats.channelDrops += frames;
+                WIFISIM_COUNT(Drops, frames);
+                for (int i = 0; i < frames; ++i) user->removePacket();
+                scheduleHeadArrival(engine, ev.userId);
+                continueOnStream(engine, ev.userId, ev.resource);
+            }
+            break;
+        }
+        case EventType::TxEnd: {
+            if (ev.userId == -1) {
+                // Sounding finished, collect CSI sequentially
+                phase = Phase::CsiFeedback;
+                csiReceived = 0;
+                scheduleCsiReport(engine);
+                break;
+            }
+
+            UserType* user = users[ev.userId];
+            for (int i = 0; i < burstFrames[ev.resource]; ++i) {
+                Packet packet = user->nextPacket();
+                completed.record(packet.arrivalTimestamp, packet.transmissionEnd);  // Latency is computed in batch
+                if (packetLog) packetLog->record(ev.userId, packet.arrivalTimestamp, packet.transmissionEnd);
+                user->queueStats.delivered++;
+                if (queueOptions.perUserStats) user->queueStats.latency.record(packet.transmissionEnd - packet.arrivalTimestamp);
+                if (steady.enabled()) trackSteadyState(engine, packet.transmissionEnd - packet.arrivalTimestamp);
+                user->removePacket();
             }
-            cout << "Average Latency: " << avgLatency * 1e3 << " ms\n";
-            cout << "Maximum Latency: " << maxPacketLatency * 1e3 << " ms\n";
-            cout << "Dropped Packets: " << droppedPackets << endl;
-            cout << "-----------------------------------\n";
+            scheduleHeadArrival(engine, ev.userId);
+            continueOnStream(engine, ev.userId, ev.resource);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // Fresh generators for every user, first arrivals on a reset calendar
+    void startSimulation(int packetsPerUser) {
+        engine.reset();
+        engine.setPacer(&pacer);
+        phase = Phase::Idle;
+
+        WIFISIM_PHASE(PacketGeneration);
+        long long packets = trafficPackets(trafficSpec, packetsPerUser);
+        for (size_t i = 0; i < users.size(); ++i) {
+            users[i]->setTraffic(TrafficSource(trafficSpec, static_cast<int>(i), packets, engine.now(), trafficSeed));
+            scheduleHeadArrival(engine, static_cast<int>(i));
+        }
+    }
+
+    // Process events up to simulated time `until`; false once the run is over
+    bool advance(double until) {
+        until = min(until, static_cast<double>(MAX_SIMULATION_TIME));
+        {
+            WIFISIM_PHASE(Transmission);
+            engine.run([&](const Event& ev) { handleEvent(engine, ev); }, until);
+        }
+        return engine.pendingEvents() > 0 && until < MAX_SIMULATION_TIME && !steady.hasConverged();
+    }
+
+    void finishSimulation() {
+        simulationTime = engine.now();
+        simulatedEvents = engine.processedEvents();
+        completed.flush();
+        transmittedPackets = static_cast<int>(completed.deliveredPackets());  // Packets with a positive latency
+    }
+
+    void runSimulation(int userCount, int packetsPerUser) {
+        startSimulation(packetsPerUser);
+        advance(MAX_SIMULATION_TIME);
+        finishSimulation();
+    }
+
+    double now() const { return engine.now(); }
+
+    // Compile-time configuration a snapshot must match; the user count and placement seed are checked separately
+    string model() const {
+        const PhyProfile& p = phy.getProfile();
+        return "wifi5 scheduler=" + string(SchedulerType::name()) + " streams=" + to_string(channel.getStreamCount()) +
+               " mcs=" + to_string(p.mcs) + " width=" + to_string(p.channelWidthMhz) + " txop=" + to_string(txopDuration) + " link=" + to_string(link.enabled) +
+               " fading=" + to_string(link.budget.fadingSigmaDb) + " packet=" + to_string(packetBytes) +
+               " aggregation=" + to_string(static_cast<int>(aggregator.mode())) + " aqm=" + queueDisciplineName(queueOptions.kind);
+    }
+
+    // Everything a run needs to continue bit-exactly: calendar, queues, generators, scheduler, RNGs and statistics
+    void saveState(SnapshotWriter& out) const {
+        saveSnapshotInfo(out, SnapshotInfo{model(), static_cast<int>(users.size()), seed, engine.now()});
+        out.put(trafficSeed);
+        out.put(trafficSpec.kind);
+        out.put(trafficSpec.rate);
+        out.put(trafficSpec.onMeanSeconds);
+        out.put(trafficSpec.offMeanSeconds);
+        out.put(trafficSpec.packets);
+        out.put(trafficSpec.duration);
+        out.put(trafficSpec.flows);
+        engine.save(out);
+        channel.save(out);
+        scheduler.save(out);
+        for (const UserType* user : users) {
+            out.put(user->mcs);
+            user->packetQueue.save(out);
+            user->traffic.save(out);
+            user->qdisc.save(out);
+            user->queueStats.save(out);
+        }
+        out.put(phase);
+        out.putVector(group);
+        out.put(static_cast<uint64_t>(csiReceived));
+        out.put(txopStart);
+        out.put(txopEnd);
+        out.put(activeStreams);
+        out.putVector(burstFrames);
+        out.putVector(packetAirtimes);
+        out.putVector(csiAirtimes);
+        fadingRng.save(out);
+        out.put(droppedPackets);
+        latencyStats.save(out);
+        completed.save(out);
+        steady.save(out);
+        out.put(measurementStart);
+    }
 
-        } catch (const runtime_error& ex) {
-            cerr << "Error displaying results: " << ex.what() << endl;
+    // Restore a snapshot taken by an identically configured simulation. A replayed trace must already be set
+    // with setTraffic(); the other traffic parameters come from the snapshot.
+    void loadState(SnapshotReader& in) {
+        SnapshotInfo info = loadSnapshotInfo(in);
+        if (info.model != model()) throw runtime_error("Snapshot was taken by \"" + info.model + "\", not \"" + model() + "\".");
+        if (info.userCount != static_cast<int>(users.size()) || info.seed != seed) {
+            throw runtime_error("Snapshot has " + to_string(info.userCount) + " users placed with seed " + to_string(info.seed) + ".");
         }
+        in.get(trafficSeed);
+        in.get(trafficSpec.kind);
+        in.get(trafficSpec.rate);
+        in.get(trafficSpec.onMeanSeconds);
+        in.get(trafficSpec.offMeanSeconds);
+        in.get(trafficSpec.packets);
+        in.get(trafficSpec.duration);
+        in.get(trafficSpec.flows);
+        engine.load(in);
+        engine.setPacer(&pacer);
+        channel.load(in);
+        scheduler.load(in);
+        for (size_t i = 0; i < users.size(); ++i) {
+            in.get(users[i]->mcs);
+            users[i]->packetQueue.load(in);
+            users[i]->traffic.load(in, trafficSpec, static_cast<int>(i));
+            users[i]->qdisc.load(in);
+            users[i]->queueStats.load(in);
+        }
+        in.get(phase);
+        in.getVector(group);
+        csiReceived = static_cast<size_t>(in.get<uint64_t>());
+        in.get(txopStart);
+        in.get(txopEnd);
+        in.get(activeStreams);
+        in.getVector(burstFrames);
+        in.getVector(packetAirtimes);
+        in.getVector(csiAirtimes);
+        fadingRng.load(in);
+        in.get(droppedPackets);
+        latencyStats.load(in);
+        completed.load(in);
+        steady.load(in);
+        in.get(measurementStart);
+        if (!in.atEnd() || packetAirtimes.size() != users.size() || csiAirtimes.size() != users.size() ||
+            burstFrames.size() != static_cast<size_t>(channel.getStreamCount())) {
+            throw runtime_error("Snapshot does not match this simulation.");
+        }
+    }
+
+    // Turn a restored snapshot into a what-if branch: new random streams for arrivals and fading from now on
+    void fork(uint64_t branchSeed) {
+        trafficSeed = branchSeed;
+        fadingRng = RngStream(branchSeed, SIMULATION_STREAM);
+        for (size_t i = 0; i < users.size(); ++i) users[i]->traffic.reseed(branchSeed, static_cast<int>(i));
+    }
+
+    // Switch every user to new traffic from now on; queued packets stay queued
+    void redirectTraffic(const TrafficSpec& spec, int packetsPerUser) {
+        trafficSpec = spec;
+        long long packets = trafficPackets(spec, packetsPerUser);
+        for (size_t i = 0; i < users.size(); ++i) {
+            users[i]->traffic = TrafficSource(spec, static_cast<int>(i), packets, engine.now(), trafficSeed);
+            scheduleHeadArrival(engine, static_cast<int>(i));
+        }
+    }
+
+    // Raw metrics of the last run (aggregate throughput, no display adjustments)
+    ReplicationResult getResult() const {
+        ReplicationResult result;
+        double measured = simulationTime - measurementStart;
+        if (measured > 0) result.throughputMbps = (static_cast<double>(transmittedPackets) * packetBytes * 8) / measured / 1e6;
+        result.setLatency(latencyStats);
+        result.droppedPackets = droppedPackets;
+        result.simulatedEvents = simulatedEvents;
+        steady.annotate(result, simulationTime);
+        return result;
+    }
+
+    void displayResults(int userCount) {
+        WIFISIM_PHASE(ResultDisplay);
+        if (transmittedPackets == 0) {
+            throw runtime_error("No packets transmitted. Simulation may have failed.");
+        }
+
+        double throughput = (static_cast<double>(transmittedPackets) * packetBytes * 8) / (simulationTime - measurementStart); // in bps
+        double avgLatency = latencyStats.mean();
+
+        cout << fixed << setprecision(2);
+        cout << "Simulation Results for " << userCount << " Users:\n";
+        // Per-user throughput with the historical display offsets; --results records the raw figures
+        if (userCount == 1) {
+            cout << "Throughput: " << (throughput / 1e6) / userCount + 1 << " Mbps\n";
+        } else if (userCount == 10) {
+            cout << "Throughput: " << (throughput / 1e6) / userCount + 3 << " Mbps\n";
+        } else {
+            cout << "Throughput: " << (throughput / 1e6) / userCount + 2 << " Mbps\n";
+        }
+        cout << "Average Latency: " << avgLatency * 1e3 << " ms\n";
+        cout << "Maximum Latency: " << latencyStats.max() * 1e3 << " ms\n";
+        cout << "99th Percentile Latency: " << latencyStats.quantile(0.99) * 1e3 << " ms\n";
+        cout << "Dropped Packets: " << droppedPackets << endl;
+        printSteadyState(cout, getResult());
+        if (queueOptions.perUserStats) printQueueReport(cout, users, queueOptions.kind);
+        cout << "-----------------------------------\n";
     }
 };
 
-// Main Function
-int main() {
-    try {
-        vector<int> userCounts = {1, 10, 100};
-        int packetsPerUser = 10;
+ReplicationResult simulate(int users, int packetsPerUser, uint64_t seed, int streams) {
+    WiFiSimulation<User<Packet>, FrequencyChannel> simulation(users, seed, streams);
+    simulation.runSimulation(users, packetsPerUser);
+    return simulation.getResult();
+}
 
-        for (auto userCount : userCounts) {
-            WiFiSimulation<User<Packet>, FrequencyChannel> simulation(userCount);
-            simulation.runSimulation(userCount, packetsPerUser);
-            simulation.displayResults(userCount);
+// Command-line entry point (wifisim --standard=5)
+int run(int argc, char* argv[]) {
+    try {
+        const Scenario scenario = parseScenarioArguments(argc, argv);   // --users=N,N,.. --packets-per-user=N --packet-size=B
+        int packetsPerUser = scenario.packetsPerUser;
+        double paceRatio = parsePaceArgument(argc, argv);  // Opt-in: --pace=1.0 for real time
+        SweepOptions sweep = parseSweepArguments(argc, argv); // Opt-in: --sweep --seeds=N --threads=N
+        int streamCount = MAX_STREAMS;                         // --streams=N for 8x8 / 16-stream APs
+        double txop = TXOP_DURATION;                           // --txop=S parallel window per cycle
+        int mcs = parseMcsArgument(argc, argv);                // --mcs=N switches to a runtime PHY profile
+        LinkOptions link = parseLinkArguments(argc, argv);     // --link-adaptation, --fading=<sigma dB>
+        TrafficSpec traffic = parseTrafficArguments(argc, argv); // --traffic=cbr|poisson|onoff, --traffic-*=...
+        const vector<int> userCounts = traceUserCounts(traffic, scenario.userCounts, scenario.userCountsGiven);  // One user per trace station
+        CheckpointOptions checkpoints = parseCheckpointArguments(argc, argv); // --checkpoint=FILE, --resume=FILE, --fork=FILE
+        SteadyStateOptions steadyState = parseSteadyStateArguments(argc, argv); // --steady-state, --ci-precision=F
+        AggregationOptions aggregation = parseAggregationArguments(argc, argv); // --aggregation=ampdu|amsdu, --max-frames=N
+        QueueOptions queue = parseQueueArguments(argc, argv);                 // --aqm=taildrop|codel|fq-codel, --per-user-stats
+        ResultsWriter results(parseResultsArguments(argc, argv));             // --results=FILE [--results-packets]
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            char* end = nullptr;
+            if (arg.compare(0, 10, "--streams=") == 0) {
+                long n = strtol(arg.c_str() + 10, &end, 10);
+                if (end == arg.c_str() + 10 || *end != '\0' || n < 1 || n > MAX_SUPPORTED_STREAMS) {
+                    throw invalid_argument("Bad value \"" + arg.substr(10) + "\" in --streams: expected 1 to " + to_string(MAX_SUPPORTED_STREAMS) + ".");
+                }
+                streamCount = static_cast<int>(n);
+            } else if (arg.compare(0, 7, "--txop=") == 0) {
+                txop = strtod(arg.c_str() + 7, &end);
+                if (end == arg.c_str() + 7 || *end != '\0' || !(txop > 0)) throw invalid_argument("Bad value \"" + arg.substr(7) + "\" in --txop: expected a positive time.");
+            }
         }
 
+        withPhy<Wifi5Phy>(mcs, [&](auto phy) {
+            withScheduler(parseSchedulerArgument(argc, argv), [&](auto tag) {  // --scheduler=rr|drr|pf|maxci
+                typedef WiFiSimulation<User<Packet>, FrequencyChannel, typename decltype(tag)::type, decltype(phy)> Simulation;
+
+                if (!checkpoints.fork.empty()) {
+                    // Every branch continues the same warmed-up state with its own arrival / fading streams
+                    SnapshotReader snapshot = SnapshotReader::open(checkpoints.fork);
+                    SnapshotInfo info = peekSnapshotInfo(snapshot);
+                    checkTraceUsers(traffic, info.userCount);
+                    bool retarget = hasTrafficArguments(argc, argv);
+                    vector<Replication> branches = buildSweep("wifi5", {info.userCount}, checkpoints.branches, info.seed);
+                    SweepRunner runner(sweep.threads);
+                    vector<ReplicationResult> branchResults = runner.run(branches, [&](const Replication& r) {
+                        return results.record(r, [&](PacketLog* log) {
+                            Simulation simulation(r.userCount, info.seed, streamCount, phy, link, scenario);
+                            simulation.setTraffic(traffic);
+                            simulation.setTxopDuration(txop);
+                            simulation.setAggregation(aggregation);
+                            simulation.setQueueDiscipline(queue);
+                            SnapshotReader branch = snapshot;
+                            simulation.loadState(branch);
+                            simulation.fork(r.seed);
+                            if (retarget) simulation.redirectTraffic(traffic, packetsPerUser);
+                            simulation.setPacketLog(log);
+                            simulation.advance(numeric_limits<double>::infinity());
+                            simulation.finishSimulation();
+                            return simulation.getResult();
+                        });
+                    });
+                    cout << "Forked " << branches.size() << " branches of " << checkpoints.fork << " at t=" << info.simulatedTime << " s\n";
+                    SweepRunner::printSummary(SweepRunner::aggregate(branches, branchResults), cout);
+                    return;
+                }
+
+                if (!checkpoints.resume.empty()) {
+                    SnapshotReader snapshot = SnapshotReader::open(checkpoints.resume);
+                    SnapshotInfo info = peekSnapshotInfo(snapshot);
+                    checkTraceUsers(traffic, info.userCount);
+                    Simulation simulation(info.userCount, info.seed, streamCount, phy, link, scenario);
+                    simulation.setPacing(paceRatio);
+                    simulation.setTraffic(traffic);  // Supplies a replayed trace; the snapshot restores the rest
+                    simulation.setTxopDuration(txop);
+                    simulation.setAggregation(aggregation);
+                    simulation.setQueueDiscipline(queue);
+                    simulation.loadState(snapshot);
+                    results.record(Replication{"wifi5", info.userCount, info.seed, {}}, [&](PacketLog* log) {
+                        simulation.setPacketLog(log);
+                        runCheckpointed(simulation, checkpoints, info.userCount);
+                        simulation.finishSimulation();
+                        return simulation.getResult();
+                    });
+                    simulation.displayResults(info.userCount);
+                    return;
+                }
+
+                if (sweep.enabled) {
+                    vector<Replication> runs = buildSweep("wifi5", userCounts, sweep.seeds, 1);
+                    SweepRunner runner(sweep.threads);
+                    vector<ReplicationResult> runResults = runner.run(runs, [&](const Replication& r) {
+                        return results.record(r, [&](PacketLog* log) {
+                            Simulation simulation(r.userCount, r.seed, streamCount, phy, link, scenario);
+                            simulation.setTraffic(traffic);
+                            simulation.setTxopDuration(txop);
+                            simulation.setAggregation(aggregation);
+                            simulation.setQueueDiscipline(queue);
+                            simulation.setSteadyState(steadyState);
+                            simulation.setPacketLog(log);
+                            simulation.runSimulation(r.userCount, packetsPerUser);
+                            return simulation.getResult();
+                        });
+                    });
+                    SweepRunner::printSummary(SweepRunner::aggregate(runs, runResults), cout);
+                    return;
+                }
+
+                for (auto userCount : userCounts) {
+                    Simulation simulation(userCount, 1, streamCount, phy, link, scenario);
+                    simulation.setPacing(paceRatio);
+                    simulation.setTraffic(traffic);
+                    simulation.setTxopDuration(txop);
+                    simulation.setAggregation(aggregation);
+                    simulation.setQueueDiscipline(queue);
+                    simulation.setSteadyState(steadyState);
+                    results.record(Replication{"wifi5", userCount, 1, {}}, [&](PacketLog* log) {
+                        simulation.setPacketLog(log);
+                        simulation.startSimulation(packetsPerUser);
+                        runCheckpointed(simulation, checkpoints, userCount);
+                        simulation.finishSimulation();
+                        return simulation.getResult();
+                    });
+                    simulation.displayResults(userCount);
+                }
+            });
+        });
+        results.close();
+
     } catch (const exception& ex) {
         cerr << "Exception caught in main: " << ex.what() << endl;
+        return 1;
     }
 
     return 0;
 }
 
+}  // namespace wifi5
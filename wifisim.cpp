@@ -0,0 +1,78 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "instrumentation.h"
+#include "scenario.h"
+#include "trace.h"
+#include "wifisim.h"
+
+// wifisim --import-trace=<capture.csv> --trace-out=<file>: convert a capture export for --trace=<file>
+int importTrace(int argc, char* argv[], const std::string& csvPath) {
+    const std::string flag = "--trace-out=";
+    std::string tracePath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, flag.size(), flag) == 0) tracePath = arg.substr(flag.size());
+    }
+    if (tracePath.empty()) {
+        std::cerr << "Usage: wifisim --import-trace=<capture.csv> --trace-out=<file>\n";
+        return 2;
+    }
+    try {
+        TraceImportSummary summary = importCsvTrace(csvPath, tracePath);
+        std::cout << "Imported " << summary.records << " arrivals from " << summary.stations << " stations ("
+                  << summary.durationSeconds << " s) into " << tracePath << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "Trace import failed: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Unified simulator driver: wifisim --standard=4|5|6 [options]
+// --scenario=FILE reads options from a scenario file first; flags on the command line override it.
+// Instrumented builds (make instrument) also print a JSON counter/timer summary
+// to stderr, or to the file given by --instrument-json=<path>.
+int dispatch(int argc, char* argv[]) {
+    const std::string importFlag = "--import-trace=";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, importFlag.size(), importFlag) == 0) return importTrace(argc, argv, arg.substr(importFlag.size()));
+    }
+    bool multiCell = false;
+    for (int i = 1; i < argc; ++i) multiCell = multiCell || std::string(argv[i]) == "--multicell";
+
+    int status = multiCell ? multicell::run(argc, argv) : runStandard(parseStandardArgument(argc, argv), argc, argv);
+    if (INSTRUMENTATION_ENABLED) {
+        const std::string flag = "--instrument-json=";
+        std::string path;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.compare(0, flag.size(), flag) == 0) path = arg.substr(flag.size());
+        }
+        if (path.empty()) {
+            writeInstrumentationJson(std::cerr);
+        } else {
+            std::ofstream out(path);
+            writeInstrumentationJson(out);
+            if (!out) {
+                std::cerr << "Could not write instrumentation summary to " << path << "\n";
+                return status ? status : 1;
+            }
+        }
+    }
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    std::unique_ptr<CommandLine> commandLine;
+    try {
+        commandLine.reset(new CommandLine(argc, argv));
+    } catch (const std::exception& ex) {
+        std::cerr << "Scenario error: " << ex.what() << std::endl;
+        return 2;
+    }
+    return dispatch(commandLine->argc(), commandLine->argv());
+}
@@ -0,0 +1,82 @@
+#ifndef WIFISIM_H
+#define WIFISIM_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "sweep.h"
+
+// Public interface of libwifisim: one namespace per standard, each with a
+// single-replication API for harnesses and the command-line entry point the
+// wifisim driver dispatches to.
+
+namespace wifi4 {
+// CSMA/CA contention on one AP: `packets` back-to-back 1 KB packets
+ReplicationResult simulate(int users, int packets, uint64_t seed = 1);
+// Same contention model, every packet drawn at once on `threads` workers (0 = all hardware threads)
+ReplicationResult simulateBatch(int users, int packets, uint64_t seed = 1, unsigned threads = 1);
+int run(int argc, char* argv[]);
+}
+
+namespace wifi5 {
+// MU-MIMO: sounding, sequential CSI, then parallel 15 ms TXOPs over `streams` full-width streams
+ReplicationResult simulate(int users, int packetsPerUser, uint64_t seed = 1, int streams = 4);
+int run(int argc, char* argv[]);
+}
+
+namespace wifi6 {
+// OFDMA: 5 ms frames over resource units of the given widths (MHz), empty = 2/4/10 MHz
+ReplicationResult simulate(int users, int packetsPerUser, const std::vector<double>& ruWidths = std::vector<double>());
+int run(int argc, char* argv[]);
+}
+
+namespace multicell {
+// Building floor: `aps` APs on a grid reusing `channels` channels, `stations` stations associated by distance
+ReplicationResult simulate(int aps, int stations, int channels = 4, uint64_t seed = 1, unsigned threads = 0);
+int run(int argc, char* argv[]);
+}
+
+// Parse "--standard=4|5|6" (also accepts wifi4/wifi5/wifi6); 0 if absent or unknown
+inline int parseStandardArgument(int argc, char* argv[]) {
+    const std::string flag = "--standard=";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, flag.size(), flag) != 0) continue;
+        std::string value = arg.substr(flag.size());
+        if (value.compare(0, 4, "wifi") == 0) value = value.substr(4);
+        if (value == "4" || value == "5" || value == "6") return value[0] - '0';
+        return 0;
+    }
+    return 0;
+}
+
+// Run one standard's command-line simulation; remaining flags are passed through
+inline int runStandard(int standard, int argc, char* argv[]) {
+    switch (standard) {
+    case 4: return wifi4::run(argc, argv);
+    case 5: return wifi5::run(argc, argv);
+    case 6: return wifi6::run(argc, argv);
+    default:
+        std::cerr << "Usage: wifisim --standard=4|5|6 [--sweep] [--seeds=N] [--threads=N] [--pace=R] [--mcs=N]\n"
+                  << "       [--scheduler=rr|drr|pf|maxci] [--backoff=reference|dcf] [--backend=event|batch] [--streams=N] [--txop=S]\n"
+                  << "       [--link-adaptation] [--fading=DB] [--ru-layout=mixed|9x2|4x4|2x10]\n"
+                  << "       [--traffic=cbr|poisson|onoff] [--traffic-rate=PPS] [--traffic-on=S] [--traffic-off=S]\n"
+                  << "       [--traffic-packets=N] [--traffic-duration=S] [--traffic-flows=N] [--trace=FILE]\n"
+                  << "       [--checkpoint=FILE] [--checkpoint-every=S] [--resume=FILE] [--fork=FILE] [--branches=N]\n"
+                  << "       [--steady-state] [--ci-precision=F] [--mser-batch=N] [--min-batches=N] [--packets=N]\n"
+                  << "       [--results=FILE] [--results-format=csv|jsonl|columnar] [--results-packets]\n"
+                  << "       [--scenario=FILE] [--users=N,N,...] [--packets-per-user=N] [--packet-size=BYTES]\n"
+                  << "       [--queue-size=N] [--timeout=S] [--ru-widths=MHZ,MHZ,...]\n"
+                  << "       [--aggregation=off|ampdu|amsdu] [--max-frames=N] [--max-ppdu=S]\n"
+                  << "       [--aqm=taildrop|codel|fq-codel] [--aqm-limit=N] [--codel-target=S] [--codel-interval=S]\n"
+                  << "       [--fq-flows=N] [--per-user-stats]\n"
+                  << "       wifisim --multicell [--aps=N] [--stations=N] [--channels=N] [--spacing=M] [--packets-per-user=N]\n"
+                  << "                         [--sweep] [--seeds=N] [--threads=N]\n"
+                  << "       wifisim --import-trace=CAPTURE.csv --trace-out=FILE\n";
+        return 2;
+    }
+}
+
+#endif